@@ -0,0 +1,457 @@
+#ifndef WLP4AST_H
+#define WLP4AST_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include "wlp4grammar.h"
+#include "wlp4symbols.h"
+#include "wlp4tree.h"
+
+// Abstract syntax tree that wlp4parse --ast builds instead of the concrete
+// parse tree. Compared to the concrete tree it
+//   - drops the tokens whose lexeme is fixed (punctuation, keywords, BOF, EOF)
+//   - collapses unit productions (expr term, term factor, factor ID, ...)
+//   - flattens the recursive list productions (statements, dcls,
+//     procedures, paramlist, arglist) into one list node each
+// Everything dropped is implied by the grammar, so expandAst() gives back
+// the concrete tree node for node.
+// The AST is a smaller form for passing a program between the tools, not a
+// smaller tree to work on: TypeChecker and CodeGenerator only walk the
+// concrete tree, so wlp4type --ast and wlp4gen --ast expand it in memory
+// first and then visit every node the concrete tree has. What they save
+// is the text of the dropped nodes, to write, read and split into lines.
+// Operator chains such as a + b + c still nest one node per operator, so
+// the writer, reader and expander below all keep their own stacks.
+//
+// Text form, one node per line in preorder:
+//   R <rule>      rule node, followed by its kept children
+//   ID <lexeme>   token
+//   NUM <lexeme>  token
+//   L <count>     list: count step records, then the innermost node
+// A rule's kept children are its ID, NUM and nonterminal slots in order. A
+// list step is a rule node for the recursive rule without its recursive slot.
+// Rule and token lines may end in " : type" once wlp4type has checked the
+// tree. The type stands for every concrete node the AST node expands to:
+// the unit chain above it, the node itself, and a NULL it dropped.
+
+enum AstKind : uint8_t { AST_RULE, AST_TOKEN, AST_LIST };
+
+constexpr uint32_t NO_AST_NODE = UINT32_MAX;
+
+struct AstNode {
+  AstKind kind;
+  uint8_t symbol;       // the rule's lhs, the token kind, or the list's nonterminal
+  uint8_t childCount;   // rule nodes only
+  TreeType type;        // rule and token nodes of a checked tree
+  uint32_t value;       // rule index, lexeme index or list index
+  uint32_t firstChild;  // rule nodes only, into AstTree::children
+};
+
+struct AstList {
+  std::vector<uint32_t> steps;  // in source order once the list is closed
+  uint32_t base;                // innermost node
+};
+
+// Nonterminals whose recursive rules are flattened into list nodes
+constexpr std::string_view AST_LIST_SYMBOLS[] = {"procedures", "paramlist", "dcls", "statements", "arglist"};
+
+constexpr bool isKeptSymbol(int symbol) {
+  return symbol == TK_ID || symbol == TK_NUM || symbol >= FIRST_NONTERMINAL;
+}
+
+// How each rule maps onto the AST
+struct AstShape {
+  bool collapse[MAX_RULES] = {};      // unit rule whose node is its only child
+  int8_t spine[MAX_RULES] = {};       // slot holding the rule's own lhs, or -1
+  uint8_t keptCount[MAX_RULES] = {};  // kept slots, recursive slot excluded
+  // unitPath[x][y]: 1 + the first rule of the unit chain x => y, or 0
+  uint8_t unitPath[MAX_GRAMMAR_SYMBOLS][MAX_GRAMMAR_SYMBOLS] = {};
+};
+
+constexpr AstShape buildAstShape(const ParseTables& tables) {
+  AstShape shape;
+  for (int r = 0; r < tables.ruleCount; ++r) {
+    const Production& rule = tables.rules[r];
+    bool list = false;
+    for (std::string_view name : AST_LIST_SYMBOLS) list = list || tables.symbolNames[rule.lhs] == name;
+    shape.collapse[r] = rule.length == 1 && isKeptSymbol(rule.rhs[0]);
+    shape.spine[r] = -1;
+    for (int i = 0; i < rule.length; ++i) {
+      if (list && rule.rhs[i] == rule.lhs) {
+        if (shape.spine[r] != -1) throw "list rule recurses twice";
+        shape.spine[r] = static_cast<int8_t>(i);
+      } else if (isKeptSymbol(rule.rhs[i])) {
+        ++shape.keptCount[r];
+      }
+    }
+    if (shape.spine[r] > 0 && shape.spine[r] != rule.length - 1) throw "list rule recurses in the middle";
+  }
+
+  // Unit chains, by breadth-first search from each nonterminal
+  for (int from = FIRST_NONTERMINAL; from < tables.symbolCount; ++from) {
+    int queue[MAX_GRAMMAR_SYMBOLS] = {};
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = from;
+    while (head < tail) {
+      int symbol = queue[head++];
+      for (int r = 0; r < tables.ruleCount; ++r) {
+        if (!shape.collapse[r] || tables.rules[r].lhs != symbol) continue;
+        int to = tables.rules[r].rhs[0];
+        if (to == from || shape.unitPath[from][to] != 0) throw "ambiguous unit productions";
+        shape.unitPath[from][to] = symbol == from ? r + 1 : shape.unitPath[from][symbol];
+        if (to >= FIRST_NONTERMINAL) queue[tail++] = to;
+      }
+    }
+  }
+  return shape;
+}
+
+constexpr AstShape AST_SHAPE = buildAstShape(WLP4_PARSE_TABLES);
+
+// Owns the nodes of one AST. Lexemes live with whoever built or read the
+// tree; token nodes refer to them by their ID in that symbol table.
+class AstTree {
+  // Lists of right-recursive rules grow back to front; put them in source
+  // order once they stop growing
+  void close(uint32_t id) {
+    if (nodes[id].kind != AST_LIST) return;
+    AstList& list = lists[nodes[id].value];
+    if (AST_SHAPE.spine[nodes[list.steps.front()].value] != 0) std::reverse(list.steps.begin(), list.steps.end());
+  }
+
+public:
+  std::vector<AstNode> nodes;
+  std::vector<uint32_t> children;
+  std::vector<AstList> lists;
+
+  uint32_t addToken(int kind, uint32_t lexeme) {
+    nodes.push_back({AST_TOKEN, static_cast<uint8_t>(kind), 0, TREE_UNTYPED, lexeme, 0});
+    return nodes.size() - 1;
+  }
+
+  // Reduces by rule over its slots on the parse stack (NO_AST_NODE for
+  // dropped tokens) and returns the node that stands for the rule's lhs
+  uint32_t reduce(int ruleIdx, const uint32_t* slots) {
+    if (AST_SHAPE.collapse[ruleIdx]) return slots[0];
+    const Production& rule = WLP4_PARSE_TABLES.rules[ruleIdx];
+    int spine = AST_SHAPE.spine[ruleIdx];
+    uint32_t firstChild = children.size();
+    for (int i = 0; i < rule.length; ++i) {
+      if (i == spine || slots[i] == NO_AST_NODE) continue;
+      close(slots[i]);
+      children.push_back(slots[i]);
+    }
+    nodes.push_back({AST_RULE, rule.lhs, static_cast<uint8_t>(children.size() - firstChild), TREE_UNTYPED,
+                     static_cast<uint32_t>(ruleIdx), firstChild});
+    uint32_t id = nodes.size() - 1;
+    if (spine < 0) return id;
+
+    uint32_t inner = slots[spine];
+    if (nodes[inner].kind == AST_LIST && nodes[inner].symbol == rule.lhs) {
+      lists[nodes[inner].value].steps.push_back(id);
+      return inner;
+    }
+    close(inner);
+    lists.push_back({{id}, inner});
+    nodes.push_back({AST_LIST, rule.lhs, 0, TREE_UNTYPED, static_cast<uint32_t>(lists.size() - 1), 0});
+    return nodes.size() - 1;
+  }
+
+  void reset() {
+    nodes.clear();
+    children.clear();
+    lists.clear();
+  }
+};
+
+// Writes the tree rooted at root in the text form, in preorder with an
+// explicit stack
+inline void writeAst(std::ostream& out, const AstTree& tree, uint32_t root, const SymbolTable& lexemes) {
+  std::vector<uint32_t> pending = {root};
+  while (!pending.empty()) {
+    const AstNode& node = tree.nodes[pending.back()];
+    pending.pop_back();
+    if (node.kind == AST_TOKEN) {
+      out << TOKEN_KIND_NAMES[node.symbol] << ' ' << lexemes.name(node.value);
+      if (node.type != TREE_UNTYPED) out << " : " << TREE_TYPE_NAMES[node.type];
+      out << '\n';
+    } else if (node.kind == AST_RULE) {
+      out << "R " << node.value;
+      if (node.type != TREE_UNTYPED) out << " : " << TREE_TYPE_NAMES[node.type];
+      out << '\n';
+      for (uint32_t i = node.childCount; i-- > 0;) pending.push_back(tree.children[node.firstChild + i]);
+    } else {
+      const AstList& list = tree.lists[node.value];
+      out << "L " << list.steps.size() << '\n';
+      pending.push_back(list.base);
+      pending.insert(pending.end(), list.steps.rbegin(), list.steps.rend());
+    }
+  }
+}
+
+// Reads a whole AST in text form, with an explicit stack of the rule and
+// list nodes still waiting for children, interning its lexemes; returns
+// false if it is malformed
+inline bool readAst(std::istream& in, AstTree& tree, SymbolTable& lexemes, uint32_t& root) {
+  struct Open {
+    AstKind kind;
+    uint32_t value;               // rule index, or step count of a list
+    TreeType type;
+    std::vector<uint32_t> nodes;  // children read so far; for a list its steps, then its base
+  };
+  std::vector<Open> open;
+  std::string line;
+  while (true) {
+    if (!std::getline(in, line)) return false;
+    // A list reads its steps before its base
+    bool step = !open.empty() && open.back().kind == AST_LIST && open.back().nodes.size() < open.back().value;
+    TreeType type = TREE_UNTYPED;
+    size_t colon = line.find(" : ");
+    if (colon != std::string::npos) {
+      type = treeType(std::string_view(line).substr(colon + 3));
+      if (type == TREE_UNTYPED) return false;
+      line.resize(colon);
+    }
+    size_t space = line.find(' ');
+    if (space == std::string::npos) return false;
+    std::string_view tag = std::string_view(line).substr(0, space);
+    std::string value = line.substr(space + 1);
+
+    uint32_t id;
+    if (tag == "ID" || tag == "NUM") {
+      if (step || value.empty()) return false;
+      id = tree.addToken(tag == "ID" ? TK_ID : TK_NUM, lexemes.intern(value));
+      tree.nodes[id].type = type;
+    } else {
+      char* end = nullptr;
+      unsigned long number = std::strtoul(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0') return false;
+      if (tag == "R") {
+        if (number >= static_cast<unsigned long>(WLP4_PARSE_TABLES.ruleCount) || AST_SHAPE.collapse[number]) return false;
+        if (step != (AST_SHAPE.spine[number] >= 0)) return false;
+        if (AST_SHAPE.keptCount[number] > 0) {
+          open.push_back({AST_RULE, static_cast<uint32_t>(number), type, {}});
+          continue;
+        }
+        tree.nodes.push_back({AST_RULE, WLP4_PARSE_TABLES.rules[number].lhs, 0, type, static_cast<uint32_t>(number),
+                              static_cast<uint32_t>(tree.children.size())});
+        id = tree.nodes.size() - 1;
+      } else if (tag == "L") {
+        if (step || type != TREE_UNTYPED || number == 0 || number >= UINT32_MAX) return false;
+        open.push_back({AST_LIST, static_cast<uint32_t>(number), TREE_UNTYPED, {}});
+        continue;
+      } else {
+        return false;
+      }
+    }
+
+    // id is complete; so is every open node it was the last child of
+    while (!open.empty()) {
+      Open& parent = open.back();
+      if (parent.kind == AST_LIST && parent.nodes.size() < parent.value && !parent.nodes.empty() &&
+          tree.nodes[id].symbol != tree.nodes[parent.nodes.front()].symbol) {
+        return false;
+      }
+      parent.nodes.push_back(id);
+      if (parent.kind == AST_RULE) {
+        if (parent.nodes.size() < AST_SHAPE.keptCount[parent.value]) break;
+        tree.nodes.push_back({AST_RULE, WLP4_PARSE_TABLES.rules[parent.value].lhs,
+                              static_cast<uint8_t>(parent.nodes.size()), parent.type, parent.value,
+                              static_cast<uint32_t>(tree.children.size())});
+        tree.children.insert(tree.children.end(), parent.nodes.begin(), parent.nodes.end());
+      } else {
+        if (parent.nodes.size() <= parent.value) break;
+        uint8_t symbol = tree.nodes[parent.nodes.front()].symbol;
+        uint32_t base = parent.nodes.back();
+        parent.nodes.pop_back();
+        tree.lists.push_back({std::move(parent.nodes), base});
+        tree.nodes.push_back({AST_LIST, symbol, 0, TREE_UNTYPED, static_cast<uint32_t>(tree.lists.size() - 1), 0});
+      }
+      id = tree.nodes.size() - 1;
+      open.pop_back();
+    }
+    if (open.empty()) {
+      root = id;
+      break;
+    }
+  }
+
+  while (std::getline(in, line)) {
+    if (!line.empty()) return false;
+  }
+  return true;
+}
+
+// Turns an AST back into the concrete parse tree, one node at a time in
+// preorder, the way ParseTree::build() takes them. The nodes still to
+// make are kept on an explicit stack, so lists and long operator chains
+// expand in constant call depth.
+class AstExpander {
+  // A concrete node or AST subtree still to make
+  struct Item {
+    enum Kind : uint8_t { NODE, OWN, TOKEN, RULE } kind;
+    int value;    // NODE: the symbol the grammar expects; TOKEN: its kind; RULE: the rule index
+    uint32_t id;  // NODE, OWN: the AST node; TOKEN, RULE: the AST node it is part of, if any
+  };
+
+  const AstTree& tree;
+  ParseTree& concrete;  // whose symbol table holds the lexemes
+  std::vector<TreeNode*>* made;
+  std::vector<Item> pending;
+  std::vector<Item> next;  // the items of the node being opened, in order
+  bool fits = true;
+
+  TreeType typeOf(uint32_t id) const {
+    return id == NO_AST_NODE ? TREE_UNTYPED : tree.nodes[id].type;
+  }
+
+  // The slots of the rule node id from first to last, except the recursive one
+  void slots(uint32_t id, int first, int last) {
+    const AstNode& node = tree.nodes[id];
+    const Production& rule = WLP4_PARSE_TABLES.rules[node.value];
+    uint32_t child = node.firstChild;
+    for (int i = 0; i < first; ++i) child += i != AST_SHAPE.spine[node.value] && isKeptSymbol(rule.rhs[i]);
+    for (int i = first; i < last; ++i) {
+      if (i == AST_SHAPE.spine[node.value]) continue;
+      if (!isKeptSymbol(rule.rhs[i])) {
+        next.push_back({Item::TOKEN, rule.rhs[i], id});
+      } else {
+        next.push_back({Item::NODE, rule.rhs[i], tree.children[child++]});
+      }
+    }
+  }
+
+  // Puts the items node id stands for where the grammar expects symbol in next
+  bool open(uint32_t id, int symbol) {
+    const AstNode& node = tree.nodes[id];
+    while (symbol != node.symbol) {
+      int step = symbol >= FIRST_NONTERMINAL ? AST_SHAPE.unitPath[symbol][node.symbol] : 0;
+      if (step == 0) return false;
+      next.push_back({Item::RULE, step - 1, id});
+      symbol = WLP4_PARSE_TABLES.rules[step - 1].rhs[0];
+    }
+
+    if (node.kind == AST_TOKEN) {
+      next.push_back({Item::OWN, 0, id});
+      return true;
+    }
+
+    if (node.kind == AST_RULE) {
+      next.push_back({Item::OWN, 0, id});
+      slots(id, 0, WLP4_PARSE_TABLES.rules[node.value].length);
+      return true;
+    }
+
+    // A left-recursive list nests from its last step inwards, so its rule
+    // nodes come first, then the base, then each step's remaining slots. A
+    // right-recursive one nests from its first step, each step complete
+    // before the next.
+    const AstList& list = tree.lists[node.value];
+    bool leftRecursive = AST_SHAPE.spine[tree.nodes[list.steps.front()].value] == 0;
+    if (leftRecursive) {
+      for (size_t i = list.steps.size(); i-- > 0;) {
+        next.push_back({Item::RULE, static_cast<int>(tree.nodes[list.steps[i]].value), NO_AST_NODE});
+      }
+      next.push_back({Item::NODE, node.symbol, list.base});
+      for (uint32_t stepId : list.steps) {
+        slots(stepId, 1, WLP4_PARSE_TABLES.rules[tree.nodes[stepId].value].length);
+      }
+    } else {
+      for (uint32_t stepId : list.steps) {
+        next.push_back({Item::RULE, static_cast<int>(tree.nodes[stepId].value), NO_AST_NODE});
+        slots(stepId, 0, WLP4_PARSE_TABLES.rules[tree.nodes[stepId].value].length - 1);
+      }
+      next.push_back({Item::NODE, node.symbol, list.base});
+    }
+    return true;
+  }
+
+  int makeRule(TreeNode& out, int ruleIdx, TreeType type) {
+    out.rule = WLP4_PARSE_TABLES.rules[ruleIdx].text;
+    out.type = TREE_TYPE_NAMES[type];
+    return WLP4_PARSE_TABLES.rules[ruleIdx].length;
+  }
+
+public:
+  // Expands the tree from root, where the grammar expects symbol. If made
+  // is given, made[id] is set to the concrete node each rule and token
+  // node of the AST becomes, below its unit chain, or for a list step to
+  // the NULL it dropped.
+  AstExpander(const AstTree& tree, ParseTree& concrete, uint32_t root, int symbol, std::vector<TreeNode*>* made = nullptr)
+      : tree(tree), concrete(concrete), made(made), pending{{Item::NODE, symbol, root}} {
+    if (made) made->assign(tree.nodes.size(), nullptr);
+  }
+
+  // Fills out with the next node and returns its child count, or -1 once
+  // there are none left or the AST does not fit the grammar
+  int nextNode(TreeNode& out) {
+    while (!pending.empty()) {
+      Item item = pending.back();
+      pending.pop_back();
+      if (item.kind == Item::NODE) {
+        if (!open(item.id, item.value)) {
+          pending.clear();
+          fits = false;
+          return -1;
+        }
+        pending.insert(pending.end(), next.rbegin(), next.rend());
+        next.clear();
+        continue;
+      }
+
+      if (item.kind == Item::RULE) return makeRule(out, item.value, typeOf(item.id));
+      if (item.kind == Item::TOKEN) {
+        // Of the dropped tokens only NULL has a type. It is that of its
+        // factor, or for a dcls step, which has no node of its own, the
+        // step's.
+        if (made && item.value == TK_NULL && !(*made)[item.id]) (*made)[item.id] = &out;
+        out.tokenKind = WLP4_PARSE_TABLES.symbolNames[item.value];
+        std::string_view spelling = item.value == SYM_BOF || item.value == SYM_EOF ? out.tokenKind : TOKEN_SPELLINGS[item.value];
+        concrete.setLexeme(out, concrete.lexemes.intern(spelling));
+        out.type = TREE_TYPE_NAMES[item.value == TK_NULL ? typeOf(item.id) : TREE_UNTYPED];
+        return 0;
+      }
+
+      const AstNode& node = tree.nodes[item.id];
+      if (made) (*made)[item.id] = &out;
+      if (node.kind == AST_RULE) return makeRule(out, node.value, node.type);
+      out.tokenKind = TOKEN_KIND_NAMES[node.symbol];
+      concrete.setLexeme(out, node.value);
+      out.type = TREE_TYPE_NAMES[node.type];
+      return 0;
+    }
+    return -1;
+  }
+
+  // Whether everything expanded so far fits the grammar
+  bool ok() const {
+    return fits;
+  }
+};
+
+// Expands the tree rooted at root into out, whose symbol table its lexeme
+// IDs are in, and returns the concrete root, or null if the AST does not
+// fit the grammar. See AstExpander for made. The whole concrete tree is
+// built, as large as ParseTree::read() would make it from the text form.
+inline TreeNode* expandAst(const AstTree& tree, uint32_t root, ParseTree& out, std::vector<TreeNode*>* made = nullptr) {
+  AstExpander expander(tree, out, root, WLP4_PARSE_TABLES.rules[0].lhs, made);
+  TreeNode* concrete = out.build([&](TreeNode& node) { return expander.nextNode(node); });
+  return expander.ok() ? concrete : nullptr;
+}
+
+// Copies the types that showsType() would print from the concrete nodes
+// expandAst() made back onto the AST
+inline void takeAstTypes(AstTree& tree, const std::vector<TreeNode*>& made) {
+  for (size_t id = 0; id < made.size(); ++id) {
+    if (made[id]) tree.nodes[id].type = showsType(made[id]) ? treeType(made[id]->type) : TREE_UNTYPED;
+  }
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wlp4input.h"
+#include "wlp4lex.h"
+#include "wlp4parser.h"
+#include "wlp4typechecker.h"
+#include "wlp4codegen.h"
+
+using namespace std;
+
+// Where the driver stops, and what it prints there
+enum EmitStage { EMIT_TOKENS, EMIT_TREE, EMIT_TYPED, EMIT_ASM };
+
+bool parseEmitStage(string_view name, EmitStage& stage) {
+    if (name == "tokens") stage = EMIT_TOKENS;
+    else if (name == "tree") stage = EMIT_TREE;
+    else if (name == "typed") stage = EMIT_TYPED;
+    else if (name == "asm") stage = EMIT_ASM;
+    else return false;
+    return true;
+}
+
+// Reads a non-negative decimal number; false unless text is all digits
+// and fits
+bool parseSize(string_view text, size_t& value) {
+    if (text.empty() || text.length() > 18) return false;
+    value = 0;
+    for (char c : text) {
+        if (!isdigit(static_cast<unsigned char>(c))) return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+// An --edit: remove `removed` bytes at `offset`, insert the file's contents
+struct EditOption {
+    size_t offset;
+    size_t removed;
+    const char* path = nullptr;
+};
+
+bool parseEdit(const char* text, EditOption& edit) {
+    string_view spec = text;
+    size_t first = spec.find(':');
+    size_t second = first == string_view::npos ? first : spec.find(':', first + 1);
+    if (second == string_view::npos) return false;
+    edit.path = text + second + 1;
+    return parseSize(spec.substr(0, first), edit.offset) &&
+           parseSize(spec.substr(first + 1, second - first - 1), edit.removed) && *edit.path;
+}
+
+// Usage: wlp4c [--emit=tokens|tree|typed|asm] [--jobs n] [--reuse old-tree] [--edit offset:removed:insert-file] [file]
+//        (reads stdin when no file is given)
+// Runs wlp4scan, wlp4parse, wlp4type and wlp4gen in one process, handing
+// each stage's data structures to the next instead of text. --emit stops
+// after a stage and prints what that tool prints for the same input
+// (tokens, the parse tree, the typed tree, or the assembly, which is the
+// default), byte for byte, and errors the same way it does.
+// --jobs n scans and parses on n threads; 0 uses every hardware thread.
+// --reuse takes the tree printed for an earlier version of the input and
+// copies its procedures outside the edited tokens, as wlp4parse --reuse
+// does; the new tree then goes on as its text.
+// --edit compiles the input with an edit applied: `removed` bytes at byte
+// `offset` replaced by the contents of insert-file. Only the edited lines
+// are scanned again (see relexEdit), and with --reuse, which then has to
+// be given the tree of the unedited input, the tokens relexEdit reports
+// as changed are all the parser looks at to plan the reuse.
+int main(int argc, char* argv[]) {
+    EmitStage emit = EMIT_ASM;
+    unsigned jobs = 1;
+    const char* path = nullptr;
+    const char* previousPath = nullptr;
+    EditOption edit;
+    for (int i = 1; i < argc; ++i) {
+        string_view arg = argv[i];
+        if (arg.substr(0, 7) == "--emit=") {
+            if (!parseEmitStage(arg.substr(7), emit)) {
+                cerr << "ERROR: unknown stage " << arg.substr(7) << endl;
+                return 1;
+            }
+        } else if (arg == "--reuse" && i + 1 < argc) {
+            previousPath = argv[++i];
+        } else if (arg == "--edit" && i + 1 < argc) {
+            if (!parseEdit(argv[++i], edit)) {
+                cerr << "ERROR: bad edit " << argv[i] << endl;
+                return 1;
+            }
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = strtoul(argv[++i], nullptr, 10);
+            if (jobs == 0) jobs = max(1u, thread::hardware_concurrency());
+        } else {
+            path = argv[i];
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "ERROR: cannot open " << path << endl;
+            return 1;
+        }
+    }
+
+    string inserted;
+    if (edit.path) {
+        ifstream in(edit.path, ios::binary);
+        if (!in) {
+            cerr << "ERROR: cannot open " << edit.path << endl;
+            return 1;
+        }
+        inserted.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    PreviousTree previous;
+    bool reusing = false;
+    if (previousPath) {
+        ifstream in(previousPath);
+        if (!in) {
+            cerr << "ERROR: cannot open " << previousPath << endl;
+            return 1;
+        }
+        reusing = previous.read(in);
+    }
+
+    ios::sync_with_stdio(false);
+    ParseTree tree;
+    TreeNode* root;
+    {
+        WLP4Parser parser(false, false, false);
+        parser.useThreads(jobs);
+        TokenChange change;
+
+        // Scan: the tokens go to the parser as they are, without the text
+        // round trip; the source and token vector are freed after
+        {
+            SourceBuffer source(fd);
+            if (fd != STDIN_FILENO) close(fd);
+            string_view input = source.view();
+            string edited;
+            vector<Token> tokens;
+            bool ok = scanTokensParallel(input, jobs, tokens);
+            if (ok && edit.path) {
+                if (edit.offset > input.length() || edit.removed > input.length() - edit.offset) {
+                    cerr << "ERROR: edit past the end of the input" << endl;
+                    return 1;
+                }
+                edited.assign(input);
+                ok = relexEdit(edited, tokens, {edit.offset, edit.removed, inserted}, change);
+                input = edited;
+            }
+            if (emit == EMIT_TOKENS) {
+                for (const Token& token : tokens) {
+                    cout << TOKEN_KIND_NAMES[token.kind] << ' ' << token.lexeme(input) << '\n';
+                }
+                cout.flush();
+            }
+            if (!ok) {
+                cerr << "ERROR" << endl;
+                return 1;
+            }
+            if (emit == EMIT_TOKENS) return 0;
+            for (const Token& token : tokens) parser.addToken(token.kind, token.lexeme(input));
+        }
+
+        // Parse
+        if (reusing && edit.path) {
+            parser.reuseFrom(previous, change);
+        } else if (reusing) {
+            parser.reuseFrom(previous);
+        }
+        if (!parser.parse()) return 1;
+        if (emit == EMIT_TREE) {
+            parser.write(cout);
+            return 0;
+        }
+        if (reusing) {
+            // The procedures taken over are lines of the old tree
+            stringstream text;
+            parser.write(text);
+            root = tree.read([&](string& line) { return static_cast<bool>(getline(text, line)); });
+            if (!root) {
+                cerr << "ERROR" << endl;
+                return 1;
+            }
+        } else {
+            root = parser.buildTree(tree);
+        }
+    }
+
+    // Type check
+    TypeChecker checker;
+    if (!checker.check(root, tree.lexemes.size())) {
+        cerr << "ERROR" << endl;
+        return 1;
+    }
+    if (emit == EMIT_TYPED) {
+        writeTree(cout, root);
+        return 0;
+    }
+
+    // wlp4gen only sees the types wlp4type prints, so drop the rest
+    walkPreorder(root, [](TreeNode* node, TreeNode*) {
+        if (!showsType(node)) node->type.clear();
+        return true;
+    });
+
+    // Generate code
+    CodeGenerator generator(cout);
+    generator.generate(root, tree.lexemes.size());
+    return 0;
+}
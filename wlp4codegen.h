@@ -0,0 +1,801 @@
+#ifndef WLP4CODEGEN_H
+#define WLP4CODEGEN_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "wlp4tree.h"
+
+// MIPS code generation for a typed parse tree, as wlp4gen and wlp4c run
+// it. The generator reads the types that wlp4type writes out, so a tree
+// checked in the same process should only keep those (see showsType()).
+
+// Symbol information; names are lexeme IDs
+struct Symbol {
+    uint32_t name;
+    std::string type;
+    int offset;  // Offset from frame pointer $29
+};
+
+// Procedure information  
+struct Procedure {
+    uint32_t name;  // NO_SYMBOL where no procedure has the name
+    std::vector<std::string> signature;  // Parameter types in order
+    std::vector<uint32_t> paramNames;  // Parameter names in order
+    std::vector<Symbol> symbols;  // All variables in procedure, parameters first
+    int paramCount;
+    int localCount;
+
+    Procedure() : name(NO_SYMBOL), paramCount(0), localCount(0) {}
+};
+
+class CodeGenerator {
+private:
+    std::ostream& out;
+    std::vector<Procedure> procedures;  // Indexed by the lexeme ID of the name
+    std::vector<const Symbol*> frame;  // The current procedure's variables by lexeme ID, null for the rest
+    uint32_t currentProc;
+    uint32_t wain;  // Lexeme ID of wain's WAIN token
+    int labelCounter;
+    bool needsInit;  // Whether wain takes int* parameter
+
+    // Helper functions for code generation
+    void push(std::string_view reg) {
+        out << "sw " << reg << ", -4($30)" << '\n';
+        out << "sub $30, $30, $4" << '\n';
+    }
+
+    void pop(std::string_view reg) {
+        out << "add $30, $30, $4" << '\n';
+        out << "lw " << reg << ", -4($30)" << '\n';
+    }
+
+    std::string newLabel(const std::string& prefix) {
+        return prefix + std::to_string(labelCounter++);
+    }
+
+    // Makes name the current procedure, whose variables symbol() finds
+    void enterProcedure(uint32_t name) {
+        if (currentProc < procedures.size()) {
+            for (const Symbol& sym : procedures[currentProc].symbols) frame[sym.name] = nullptr;
+        }
+        currentProc = name;
+        for (const Symbol& sym : procedures[name].symbols) frame[sym.name] = &sym;
+    }
+
+    // The current procedure's variable varName; offset 0 if it has none
+    const Symbol& symbol(uint32_t varName) const {
+        static const Symbol undeclared{NO_SYMBOL, "", 0};
+        return varName < frame.size() && frame[varName] ? *frame[varName] : undeclared;
+    }
+
+    // First pass: collect symbols and build procedure table
+    void collectSymbols(TreeNode* root) {
+        walkPreorder(root, [&](TreeNode* node, TreeNode*) {
+            if (node->rule == "procedure INT ID LPAREN params RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE") {
+                collectProcedure(*node);
+            } else if (node->rule == "main INT WAIN LPAREN dcl COMMA dcl RPAREN LBRACE dcls statements RETURN expr SEMI RBRACE") {
+                collectWain(*node);
+            }
+            return true;
+        });
+    }
+
+    void collectProcedure(const TreeNode& node) {
+        Procedure proc;
+        proc.name = node.children[1]->lexemeId;  // ID
+        currentProc = proc.name;
+
+        // Collect parameters
+        const TreeNode& params = *node.children[3];
+        collectParams(params, proc);
+
+        // Collect local declarations
+        const TreeNode& dcls = *node.children[6];
+        collectDecls(dcls, proc);
+
+        // Fix parameter offsets
+        fixParameterOffsets(proc);
+
+        procedures[proc.name] = std::move(proc);
+    }
+
+    void collectWain(const TreeNode& node) {
+        Procedure proc;
+        proc.name = node.children[1]->lexemeId;  // WAIN
+        currentProc = proc.name;
+        wain = proc.name;
+
+        // Collect wain parameters
+        const TreeNode& dcl1 = *node.children[3];  // First parameter
+        const TreeNode& dcl2 = *node.children[5];  // Second parameter
+
+        collectDcl(dcl1, proc, true);  // Parameter
+        collectDcl(dcl2, proc, true);  // Parameter
+
+        // Check if first parameter is int* (need init)
+        needsInit = (dcl1.children[0]->rule == "type INT STAR");
+
+        // Collect local declarations
+        const TreeNode& dcls = *node.children[8];
+        collectDecls(dcls, proc);
+
+        // Fix parameter offsets
+        fixParameterOffsets(proc);
+
+        procedures[proc.name] = std::move(proc);
+    }
+
+    void collectParams(const TreeNode& params, Procedure& proc) {
+        if (params.rule == "params .EMPTY") return;
+
+        // params -> paramlist
+        const TreeNode& paramlist = *params.children[0];
+        collectParamlist(paramlist, proc);
+    }
+
+    void collectParamlist(const TreeNode& paramlist, Procedure& proc) {
+        const TreeNode* list = &paramlist;
+        while (list->rule == "paramlist dcl COMMA paramlist") {
+            collectDcl(*list->children[0], proc, true);
+            list = list->children[2];
+        }
+        if (list->rule == "paramlist dcl") {
+            collectDcl(*list->children[0], proc, true);
+        }
+    }
+
+    void collectDecls(const TreeNode& dcls, Procedure& proc) {
+        // Collect the declarations in source order
+        for (const TreeNode* node : dcls.items) {
+            collectDcl(*node->children[0], proc, false);  // Collect this dcl
+        }
+    }
+
+    void collectDcl(const TreeNode& dcl, Procedure& proc, bool isParam) {
+        Symbol sym;
+        const TreeNode& type = *dcl.children[0];
+        const TreeNode& id = *dcl.children[1];
+
+        sym.name = id.lexemeId;
+        sym.type = (type.rule == "type INT") ? "int" : "int*";
+
+        if (isParam) {
+            // Parameters have positive offsets: first param gets highest offset
+            sym.offset = 0;  // Temporary, will fix later
+            proc.signature.push_back(sym.type);
+            proc.paramNames.push_back(sym.name);
+            proc.paramCount++;
+        } else {
+            // Local variables have non-positive offsets: -4*i where i=local variable index
+            sym.offset = -4 * proc.localCount;
+            proc.localCount++;
+        }
+
+        proc.symbols.push_back(sym);
+    }
+
+    void fixParameterOffsets(Procedure& proc) {
+        // Assign offsets: first parameter gets highest offset 4*n, last gets 4
+        for (int i = 0; i < proc.paramCount; i++) {
+            proc.symbols[i].offset = 4 * (proc.paramCount - i);
+        }
+    }
+
+    // Second pass: generate code
+    void generateCode(const TreeNode& node) {
+
+        out << ".import init" << '\n';
+        out << ".import new" << '\n';
+        out << ".import delete" << '\n';
+        out << ".import print" << '\n';
+        if (node.rule == "start BOF procedures EOF") {
+            generateStart(node);
+        }
+    }
+
+    void generateStart(const TreeNode& node) {
+        // Generate code for procedures, with wain first
+        const TreeNode& procedures = *node.children[1];
+        generateProcedures(procedures);
+    }
+
+    void generateProcedures(const TreeNode& procedures) {
+        // Generate wain first, then other procedures from last to first.
+        // procedures is right-recursive, so walk down to wain first.
+        std::vector<const TreeNode*> spine;
+        const TreeNode* rest = &procedures;
+        while (rest->rule == "procedures procedure procedures") {
+            spine.push_back(rest->children[0]);
+            rest = rest->children[1];
+        }
+        if (rest->rule == "procedures main") {
+            generateMain(*rest->children[0]);
+        }
+        for (auto procedure = spine.rbegin(); procedure != spine.rend(); ++procedure) {
+            generateProcedure(**procedure);
+        }
+    }
+
+    void generateMain(const TreeNode& main) {
+        enterProcedure(main.children[1]->lexemeId);
+        Procedure& proc = procedures[currentProc];
+
+        out << "; wain procedure" << '\n';
+        generateWainPrologue(proc);
+
+        // Generate dcls (local variable declarations)
+        const TreeNode& dcls = *main.children[8];
+        generateDcls(dcls);
+
+        // Generate statements
+        const TreeNode& statements = *main.children[9];
+        generateStatements(statements);
+
+        // Generate return expression
+        const TreeNode& expr = *main.children[11];
+        generateExpr(expr);
+
+        generateWainEpilogue(proc);
+    }
+
+    void generateProcedure(const TreeNode& procedure) {
+        std::string_view name = procedure.children[1]->lexeme;
+        enterProcedure(procedure.children[1]->lexemeId);
+        Procedure& proc = procedures[currentProc];
+
+        out << "; procedure " << name << '\n';
+        out << "P" << name << ":" << '\n';  // Prefix to avoid conflicts
+
+        generateProcPrologue(proc);
+
+        // Generate dcls (local variable declarations)
+        const TreeNode& dcls = *procedure.children[6];
+        generateDcls(dcls);
+
+        // Generate statements
+        const TreeNode& statements = *procedure.children[7];
+        generateStatements(statements);
+
+        // Generate return expression  
+        const TreeNode& expr = *procedure.children[9];
+        generateExpr(expr);
+
+        generateProcEpilogue(proc);
+    }
+
+    void generateWainPrologue(const Procedure& proc) {
+        // Initialize constants
+        out << "; begin prologue" << '\n';
+        out << "lis $4" << '\n';
+        out << ".word 4" << '\n';
+
+        // Push parameters
+        push("$1");  // First parameter
+        push("$2");  // Second parameter
+
+        // Set frame pointer
+        out << "sub $29, $30, $4" << '\n';
+
+        // Initialize local variables
+        generateLocalInits(proc);
+
+        // Call init if needed
+        if (needsInit) {
+            out << "; call init" << '\n';
+            push("$31");
+            push("$2");
+            out << "add $2, $0, $2" << '\n';  // Second parameter (array size)
+            out << "lis $5" << '\n';
+            out << ".word init" << '\n';
+            out << "jalr $5" << '\n';
+            pop("$2");
+            pop("$31");
+        } else {
+            out << "; call init with 0" << '\n';
+            push("$31");
+            push("$2");
+            out << "add $2, $0, $0" << '\n';  // 0 for non-array input
+            out << "lis $5" << '\n';
+            out << ".word init" << '\n';
+            out << "jalr $5" << '\n';
+            pop("$2");
+            pop("$31");
+        }
+
+        out << "; end prologue" << '\n';
+    }
+
+    void generateProcPrologue(const Procedure& proc) {
+        out << "; begin prologue" << '\n';
+        out << "sub $29, $30, $4" << '\n';  // Set frame pointer
+        generateLocalInits(proc);
+        out << "; end prologue" << '\n';
+    }
+
+    void generateLocalInits(const Procedure& proc) {
+        // Local variables are already handled during dcls processing
+        // This function is for explicit initialization from dcls rules
+    }
+
+    void generateDcls(const TreeNode& dcls) {
+        // Initialize the variables in source order
+        for (const TreeNode* item : dcls.items) {
+            const TreeNode& node = *item;
+            const TreeNode& dcl = *node.children[0];
+            if (node.rule == "dcls dcls dcl BECOMES NUM SEMI") {
+                // Initialize this variable with NUM value
+                const TreeNode& num = *node.children[2];
+
+                out << "; initialize " << dcl.children[1]->lexeme << " = " << num.lexeme << '\n';
+                out << "lis $5" << '\n';
+                out << ".word " << num.lexeme << '\n';
+                out << "sw $5, -4($30)" << '\n';
+                out << "sub $30, $30, $4" << '\n';
+
+            } else {
+                // Initialize this variable with NULL (1)
+                out << "; initialize " << dcl.children[1]->lexeme << " = NULL" << '\n';
+                out << "lis $5" << '\n';
+                out << ".word 1" << '\n';  // NULL is 1
+                out << "sw $5, -4($30)" << '\n';
+                out << "sub $30, $30, $4" << '\n';
+            }
+        }
+    }
+
+    void generateWainEpilogue(const Procedure& proc) {
+        out << "; begin epilogue" << '\n';
+        // Pop local variables and parameters
+        int totalVars = proc.paramCount + proc.localCount;
+        for (int i = 0; i < totalVars; i++) {
+            out << "add $30, $30, $4" << '\n';
+        }
+        out << "jr $31" << '\n';
+    }
+
+    void generateProcEpilogue(const Procedure& proc) {
+        out << "; begin epilogue" << '\n';
+        // Pop only local variables (caller pops parameters)
+        for (int i = 0; i < proc.localCount; i++) {
+            out << "add $30, $30, $4" << '\n';
+        }
+        out << "jr $31" << '\n';
+    }
+
+    // A unit of work for generateStatements(): a statements list to expand,
+    // a statement, or code to write once everything before it is written
+    struct StatementStep {
+        enum Kind { STATEMENTS, STATEMENT, CODE } kind;
+        const TreeNode* node;
+        std::string code;
+    };
+
+    // Generates the statements with an explicit stack instead of recursing
+    // into if and while bodies, so deep nesting cannot overflow the call stack
+    void generateStatements(const TreeNode& statements) {
+        std::vector<StatementStep> steps{{StatementStep::STATEMENTS, &statements, ""}};
+        std::vector<StatementStep> next;
+        while (!steps.empty()) {
+            StatementStep step = std::move(steps.back());
+            steps.pop_back();
+            next.clear();
+            if (step.kind == StatementStep::STATEMENTS) {
+                for (const TreeNode* item : step.node->items) {
+                    next.push_back({StatementStep::STATEMENT, item->children[0], ""});
+                }
+            } else if (step.kind == StatementStep::STATEMENT) {
+                generateStatement(*step.node, next);
+            } else {
+                out << step.code;
+            }
+            for (auto it = next.rbegin(); it != next.rend(); ++it) steps.push_back(std::move(*it));
+        }
+    }
+
+    // Generates a statement; the bodies of ifs and whiles, and the code
+    // after them, are left in next for generateStatements()
+    void generateStatement(const TreeNode& statement, std::vector<StatementStep>& next) {
+        if (statement.rule == "statement lvalue BECOMES expr SEMI") {
+            generateAssignment(statement);
+        } else if (statement.rule == "statement IF LPAREN test RPAREN LBRACE statements RBRACE ELSE LBRACE statements RBRACE") {
+            generateIf(statement, next);
+        } else if (statement.rule == "statement WHILE LPAREN test RPAREN LBRACE statements RBRACE") {
+            generateWhile(statement, next);
+        } else if (statement.rule == "statement PRINTLN LPAREN expr RPAREN SEMI") {
+            generatePrintln(statement);
+        } else if (statement.rule == "statement PUTCHAR LPAREN expr RPAREN SEMI") {
+            generatePutchar(statement);
+        } else if (statement.rule == "statement DELETE LBRACK RBRACK expr SEMI") {
+            generateDelete(statement);
+        }
+    }
+
+    void generateLvalueAssignment(const TreeNode& target, const TreeNode& expr) {
+        // Assigning to a parenthesized lvalue assigns to the inner one
+        const TreeNode* lvalue = &target;
+        while (lvalue->rule == "lvalue LPAREN lvalue RPAREN") lvalue = lvalue->children[1];
+
+        if (lvalue->rule == "lvalue ID") {
+            uint32_t varName = lvalue->children[0]->lexemeId;
+
+            // Special case: wain parameters go directly to registers
+            if (currentProc == wain) {
+                Procedure& proc = procedures[currentProc];
+                if (proc.paramNames.size() >= 1 && varName == proc.paramNames[0]) {
+                    // First parameter -> $1
+                    generateExpr(expr);
+                    out << "add $1, $3, $0" << '\n';
+                    const Symbol& sym = symbol(varName);
+                    out << "sw $3, " << sym.offset << "($29)" << '\n';
+                    return;
+                } else if (proc.paramNames.size() >= 2 && varName == proc.paramNames[1]) {
+                    // Second parameter -> $2  
+                    generateExpr(expr);
+                    out << "add $2, $3, $0" << '\n';
+                    const Symbol& sym = symbol(varName);
+                    out << "sw $3, " << sym.offset << "($29)" << '\n';
+                    return;
+                }
+            }
+
+            // Regular case: stack variable assignment
+            generateExpr(expr);
+            const Symbol& sym = symbol(varName);
+            out << "sw $3, " << sym.offset << "($29)" << '\n';
+        } else if (lvalue->rule == "lvalue STAR factor") {
+            // Pointer dereference assignment
+            generateExpr(expr);
+            push("$3");  // Save expr value
+            generateFactor(*lvalue->children[1]);  // Get address
+            pop("$5");   // Restore expr value
+            out << "sw $5, 0($3)" << '\n';  // Store at address
+        }
+    }
+
+    void generateAssignment(const TreeNode& statement) {
+        const TreeNode& lvalue = *statement.children[0];
+        const TreeNode& expr = *statement.children[2];
+        generateLvalueAssignment(lvalue, expr);
+    }
+
+    void generateIf(const TreeNode& statement, std::vector<StatementStep>& next) {
+        std::string elseLabel = newLabel("else");
+        std::string endLabel = newLabel("endif");
+
+        const TreeNode& test = *statement.children[2];
+        const TreeNode& thenStmts = *statement.children[5];
+        const TreeNode& elseStmts = *statement.children[9];
+
+        generateTest(test, elseLabel);  // Jump to else if test fails
+        next.push_back({StatementStep::STATEMENTS, &thenStmts, ""});
+        next.push_back({StatementStep::CODE, nullptr, "beq $0, $0, " + endLabel + "\n" + elseLabel + ":\n"});  // Jump to end
+        next.push_back({StatementStep::STATEMENTS, &elseStmts, ""});
+        next.push_back({StatementStep::CODE, nullptr, endLabel + ":\n"});
+    }
+
+    void generateWhile(const TreeNode& statement, std::vector<StatementStep>& next) {
+        std::string startLabel = newLabel("while");
+        std::string endLabel = newLabel("endwhile");
+
+        const TreeNode& test = *statement.children[2];
+        const TreeNode& stmts = *statement.children[5];
+
+        out << startLabel << ":" << '\n';
+        generateTest(test, endLabel);  // Jump to end if test fails
+        next.push_back({StatementStep::STATEMENTS, &stmts, ""});
+        next.push_back({StatementStep::CODE, nullptr, "beq $0, $0, " + startLabel + "\n" + endLabel + ":\n"});  // Jump back to start
+    }
+
+    void generateTest(const TreeNode& test, const std::string& failLabel) {
+        const TreeNode& expr1 = *test.children[0];
+        const TreeNode& op = *test.children[1];
+        const TreeNode& expr2 = *test.children[2];
+
+        generateExpr(expr1);
+        push("$3");
+        generateExpr(expr2);
+        pop("$5");  // expr1 in $5, expr2 in $3
+
+        std::string opToken(op.tokenKind);
+        bool isPointer = (expr1.type == "int*" || expr2.type == "int*");
+
+        if (opToken == "EQ") {
+            out << "bne $5, $3, " << failLabel << '\n';
+        } else if (opToken == "NE") {
+            out << "beq $5, $3, " << failLabel << '\n';
+        } else if (opToken == "LT") {
+            if (isPointer) {
+                out << "sltu $6, $5, $3" << '\n';
+            } else {
+                out << "slt $6, $5, $3" << '\n';
+            }
+            out << "beq $6, $0, " << failLabel << '\n';
+        } else if (opToken == "LE") {
+            if (isPointer) {
+                out << "sltu $6, $3, $5" << '\n';
+            } else {
+                out << "slt $6, $3, $5" << '\n';
+            }
+            out << "bne $6, $0, " << failLabel << '\n';
+        } else if (opToken == "GT") {
+            if (isPointer) {
+                out << "sltu $6, $3, $5" << '\n';
+            } else {
+                out << "slt $6, $3, $5" << '\n';
+            }
+            out << "beq $6, $0, " << failLabel << '\n';
+        } else if (opToken == "GE") {
+            if (isPointer) {
+                out << "sltu $6, $5, $3" << '\n';
+            } else {
+                out << "slt $6, $5, $3" << '\n';
+            }
+            out << "bne $6, $0, " << failLabel << '\n';
+        }
+    }
+
+    void generatePrintln(const TreeNode& statement) {
+        const TreeNode& expr = *statement.children[2];
+
+        push("$1");
+        push("$31");
+        generateExpr(expr);
+        out << "add $1, $3, $0" << '\n';
+        out << "lis $5" << '\n';
+        out << ".word print" << '\n';
+        out << "jalr $5" << '\n';
+        pop("$31");
+        pop("$1");
+    }
+
+    void generatePutchar(const TreeNode& statement) {
+        const TreeNode& expr = *statement.children[2];
+        generateExpr(expr);
+        out << "lis $5" << '\n';
+        out << ".word 0xffff000c" << '\n';
+        out << "sw $3, 0($5)" << '\n';
+    }
+
+    void generateDelete(const TreeNode& statement) {
+        const TreeNode& expr = *statement.children[3];
+
+        push("$1");
+        push("$31");
+        generateExpr(expr);
+
+        // Check if expr is NULL (1), if so, do nothing
+        std::string skipLabel = newLabel("skipdelete");
+        out << "lis $5" << '\n';
+        out << ".word 1" << '\n';
+        out << "beq $3, $5, " << skipLabel << '\n';
+
+        out << "add $1, $3, $0" << '\n';
+        out << "lis $5" << '\n';
+        out << ".word delete" << '\n';
+        out << "jalr $5" << '\n';
+
+        out << skipLabel << ":" << '\n';
+        pop("$31");
+        pop("$1");
+    }
+
+    // A unit of work for generateValue(): a node to generate the value or
+    // address of, a push or pop of a register, code to write, or the end of
+    // a new or a procedure call once its operands are generated
+    struct ExprStep {
+        enum Kind { VALUE, ADDRESS, PUSH, POP, CODE, NEW_END, CALL_END } kind;
+        const TreeNode* node;
+        std::string_view text;  // register, code, or procedure name
+        int count;              // arguments pushed, for CALL_END
+    };
+
+    void generateExpr(const TreeNode& expr) {
+        generateValue(expr, ExprStep::VALUE);
+    }
+
+    void generateFactor(const TreeNode& factor) {
+        generateValue(factor, ExprStep::VALUE);
+    }
+
+    // Generates the value of an expr, term or factor into $3, or with
+    // ADDRESS the address of an lvalue. Operands go on an explicit stack
+    // rather than the call stack, since expr and term chains are as deep as
+    // they are long.
+    void generateValue(const TreeNode& root, ExprStep::Kind kind) {
+        std::vector<ExprStep> steps{{kind, &root, "", 0}};
+        std::vector<ExprStep> next;
+        while (!steps.empty()) {
+            ExprStep step = steps.back();
+            steps.pop_back();
+            next.clear();
+            switch (step.kind) {
+                case ExprStep::VALUE: expandValue(*step.node, next); break;
+                case ExprStep::ADDRESS: expandAddress(*step.node, next); break;
+                case ExprStep::PUSH: push(step.text); break;
+                case ExprStep::POP: pop(step.text); break;
+                case ExprStep::CODE: out << step.text; break;
+                case ExprStep::NEW_END: generateNewEnd(); break;
+                case ExprStep::CALL_END: generateProcCallEnd(step.text, step.count); break;
+            }
+            steps.insert(steps.end(), next.rbegin(), next.rend());
+        }
+    }
+
+    // Writes the code for node that comes before its operands, and leaves
+    // the operands and the code after them in next
+    void expandValue(const TreeNode& node, std::vector<ExprStep>& next) {
+        auto value = [&](const TreeNode* operand) { next.push_back({ExprStep::VALUE, operand, "", 0}); };
+        auto push = [&](std::string_view reg) { next.push_back({ExprStep::PUSH, nullptr, reg, 0}); };
+        auto pop = [&](std::string_view reg) { next.push_back({ExprStep::POP, nullptr, reg, 0}); };
+        auto code = [&](std::string_view text) { next.push_back({ExprStep::CODE, nullptr, text, 0}); };
+
+        const std::string_view rule = node.rule;
+        if (rule == "expr term" || rule == "term factor") {
+            value(node.children[0]);
+        } else if (rule == "expr expr PLUS term" || rule == "expr expr MINUS term") {
+            // For expr-level operations: left is expr, right is term
+            const TreeNode* left = node.children[0];
+            const TreeNode* right = node.children[2];
+            if (rule == "expr expr PLUS term") {
+                if (left->type == "int*" && right->type == "int") {
+                    // Pointer + int
+                    value(left); push("$3"); value(right);
+                    code("mult $3, $4\nmflo $3\n");
+                    pop("$5");
+                    code("add $3, $5, $3\n");
+                } else if (left->type == "int" && right->type == "int*") {
+                    // int + Pointer
+                    value(left);
+                    code("mult $3, $4\nmflo $3\n");
+                    push("$3"); value(right); pop("$5");
+                    code("add $3, $5, $3\n");
+                } else {
+                    // int + int
+                    value(left); push("$3"); value(right); pop("$5");
+                    code("add $3, $5, $3\n");
+                }
+            } else {
+                if (left->type == "int*" && right->type == "int") {
+                    // Pointer - int
+                    value(left); push("$3"); value(right);
+                    code("mult $3, $4\nmflo $3\n");
+                    pop("$5");
+                    code("sub $3, $5, $3\n");
+                } else if (left->type == "int*" && right->type == "int*") {
+                    // Pointer - Pointer
+                    value(left); push("$3"); value(right); pop("$5");
+                    code("sub $3, $5, $3\ndiv $3, $4\nmflo $3\n");
+                } else {
+                    // int - int
+                    value(left); push("$3"); value(right); pop("$5");
+                    code("sub $3, $5, $3\n");
+                }
+            }
+        } else if (rule == "term term STAR factor" || rule == "term term SLASH factor" || rule == "term term PCT factor") {
+            // For term-level operations: left is term, right is factor
+            value(node.children[0]); push("$3"); value(node.children[2]); pop("$5");
+            if (rule == "term term STAR factor") {
+                code("mult $5, $3\nmflo $3\n");  // Multiplication
+            } else if (rule == "term term SLASH factor") {
+                code("div $5, $3\nmflo $3\n");   // Division
+            } else {
+                code("div $5, $3\nmfhi $3\n");   // Modulo
+            }
+        } else if (rule == "factor NUM") {
+            out << "lis $3" << '\n';
+            out << ".word " << node.children[0]->lexeme << '\n';
+        } else if (rule == "factor NULL") {
+            out << "lis $3" << '\n';
+            out << ".word 1" << '\n';  // NULL is 1
+        } else if (rule == "factor ID") {
+            uint32_t varName = node.children[0]->lexemeId;
+            const Symbol& sym = symbol(varName);
+            out << "lw $3, " << sym.offset << "($29)" << '\n';
+        } else if (rule == "factor LPAREN expr RPAREN") {
+            value(node.children[1]);
+        } else if (rule == "factor AMP lvalue") {
+            next.push_back({ExprStep::ADDRESS, node.children[1], "", 0});
+        } else if (rule == "factor STAR factor") {
+            value(node.children[1]);
+            code("lw $3, 0($3)\n");
+        } else if (rule == "factor NEW INT LBRACK expr RBRACK") {
+            this->push("$1");
+            this->push("$31");
+            value(node.children[3]);
+            next.push_back({ExprStep::NEW_END, nullptr, "", 0});
+        } else if (rule == "factor GETCHAR LPAREN RPAREN") {
+            out << "lis $5" << '\n';
+            out << ".word 0xffff0004" << '\n';
+            out << "lw $3, 0($5)" << '\n';
+        } else if (rule == "factor ID LPAREN RPAREN" || rule == "factor ID LPAREN arglist RPAREN") {
+            this->push("$29");
+            this->push("$31");
+
+            // Push the arguments in order
+            int argCount = 0;
+            if (rule == "factor ID LPAREN arglist RPAREN") {
+                const TreeNode* list = node.children[2];
+                while (list->rule == "arglist expr COMMA arglist") {
+                    value(list->children[0]); push("$3");
+                    argCount++;
+                    list = list->children[2];
+                }
+                if (list->rule == "arglist expr") {
+                    value(list->children[0]); push("$3");
+                    argCount++;
+                }
+            }
+            next.push_back({ExprStep::CALL_END, nullptr, node.children[0]->lexeme, argCount});
+        }
+    }
+
+    void expandAddress(const TreeNode& lvalue, std::vector<ExprStep>& next) {
+        if (lvalue.rule == "lvalue ID") {
+            uint32_t varName = lvalue.children[0]->lexemeId;
+            const Symbol& sym = symbol(varName);
+            out << "lis $3" << '\n';
+            out << ".word " << sym.offset << '\n';
+            out << "add $3, $29, $3" << '\n';
+        } else if (lvalue.rule == "lvalue STAR factor") {
+            next.push_back({ExprStep::VALUE, lvalue.children[1], "", 0});
+        } else if (lvalue.rule == "lvalue LPAREN lvalue RPAREN") {
+            next.push_back({ExprStep::ADDRESS, lvalue.children[1], "", 0});
+        }
+    }
+
+    // The rest of a new, once the size is in $3
+    void generateNewEnd() {
+        out << "add $1, $3, $0" << '\n';
+        out << "lis $5" << '\n';
+        out << ".word new" << '\n';
+        out << "jalr $5" << '\n';
+
+        // Check if allocation failed (returned 0), convert to NULL (1)
+        std::string successLabel = newLabel("allocsuccess");
+        out << "bne $3, $0, " << successLabel << '\n';
+        out << "lis $3" << '\n';
+        out << ".word 1" << '\n';
+        out << successLabel << ":" << '\n';
+
+        pop("$31");
+        pop("$1");
+    }
+
+    // The rest of a procedure call, once the arguments are pushed
+    void generateProcCallEnd(std::string_view procName, int argCount) {
+        // Make the call
+        out << "lis $5" << '\n';
+        out << ".word P" << procName << '\n';
+        out << "jalr $5" << '\n';
+
+        // Pop arguments
+        for (int i = 0; i < argCount; i++) {
+            out << "add $30, $30, $4" << '\n';
+        }
+
+        pop("$31");
+        pop("$29");
+    }
+
+public:
+    explicit CodeGenerator(std::ostream& out)
+        : out(out), currentProc(NO_SYMBOL), wain(NO_SYMBOL), labelCounter(1), needsInit(false) {}
+
+    // Writes the assembly for the tree at root, whose lexeme IDs are all
+    // below lexemeCount; nothing for an empty tree
+    void generate(TreeNode* root, size_t lexemeCount) {
+        if (!root) return;
+        procedures.assign(lexemeCount, Procedure());
+        frame.assign(lexemeCount, nullptr);
+
+        // First pass: collect symbols
+        collectSymbols(root);
+
+        // Second pass: generate code
+        generateCode(*root);
+    }
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include "wlp4lex.h"
+#include "wlp4parser.h"
+
+using namespace std;
+
+// Usage: wlp4edittest [--edits n] [--seed s]
+// Applies n random edits (20000 by default) to generated programs, in
+// chains of up to EDITS_PER_PROGRAM. Each edit goes through relexEdit and
+// has to leave the same tokens, and the same lexical error or not, as a
+// full scanTokens of the edited text, with a change whose unedited tail
+// is the same length before and after. When the text before the edit
+// parsed, the edited tokens are also parsed reusing its tree with that
+// change, and the tree (or the syntax error) has to match a full parse.
+// The edits are a mix of random bytes cut and pasted anywhere, which
+// mostly break the program, and changes that keep it valid: numbers
+// replaced, statement lines added or removed, procedures added. Prints
+// the counts and exits with 1 on the first mismatch.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o wlp4edittest wlp4edittest.cc
+
+constexpr int EDITS_PER_PROGRAM = 12;
+
+const char* const SNIPPETS[] = {
+    "", " ", "\n", "\t", "x", "a1", "12", "0", "00", "2147483647", "2147483648", "+", "-", "*", "/", "%",
+    "//", "// note\n", "/", "=", "==", "!", "!=", "<", "<=", "&", "{", "}", "(", ")", ";", ",", "[", "]",
+    "int", "return", "wain", "NULL", "new", "$", "@", "int q = 0;\n", "  c = c + 1;\n", "if (c < 1) { } else { }\n",
+};
+
+string statementLine(mt19937& rng) {
+    string n = to_string(rng() % 100);
+    switch (rng() % 4) {
+        case 0: return "  c = c + " + n + ";\n";
+        case 1: return "  if (a < b) { c = c * " + n + "; } else { c = c - 1; }\n";
+        case 2: return "  while (c < " + n + ") { c = c + 1; } // loop\n";
+        default: return "  println(c);\n";
+    }
+}
+
+string procedureText(mt19937& rng, const string& name) {
+    string text = "int " + name + "(int a, int b) {\n  int c = " + to_string(rng() % 100) + ";\n";
+    for (int i = rng() % 5; i > 0; --i) text += statementLine(rng);
+    return text + "  return c + a;\n}\n";
+}
+
+string randomProgram(mt19937& rng) {
+    string program;
+    for (int p = rng() % 6; p > 0; --p) program += procedureText(rng, "p" + to_string(p));
+    program += "int wain(int a, int b) {\n  int c = 0;\n";
+    for (int i = rng() % 6; i > 0; --i) program += statementLine(rng);
+    return program + "  return c;\n}\n";
+}
+
+// Starts of the lines of text that begin with prefix
+vector<size_t> lineStarts(const string& text, string_view prefix) {
+    vector<size_t> starts;
+    size_t pos = 0;
+    while (true) {
+        if (text.compare(pos, prefix.length(), prefix) == 0) starts.push_back(pos);
+        pos = text.find('\n', pos);
+        if (pos == string::npos) break;
+        pos++;
+    }
+    return starts;
+}
+
+// A random edit of text, whose complete scan is tokens; inserted holds the
+// new bytes
+SourceEdit randomEdit(mt19937& rng, const string& text, const vector<Token>& tokens, string& inserted) {
+    switch (rng() % 5) {
+        case 0: {
+            // A number replaced by another
+            vector<const Token*> numbers;
+            for (const Token& token : tokens) {
+                if (token.kind == TK_NUM) numbers.push_back(&token);
+            }
+            if (numbers.empty()) break;
+            const Token& number = *numbers[rng() % numbers.size()];
+            inserted = to_string(rng() % 1000);
+            return {number.offset, number.length, inserted};
+        }
+        case 1: {
+            // A statement line added before another, or before return
+            vector<size_t> lines = lineStarts(text, "  ");
+            vector<size_t> statements;
+            for (size_t start : lines) {
+                if (text.compare(start, 7, "  int c") != 0) statements.push_back(start);
+            }
+            if (statements.empty()) break;
+            inserted = statementLine(rng);
+            return {statements[rng() % statements.size()], 0, inserted};
+        }
+        case 2: {
+            // A statement line removed
+            vector<size_t> statements;
+            for (size_t start : lineStarts(text, "  ")) {
+                if (text.compare(start, 7, "  int c") != 0 && text.compare(start, 8, "  return") != 0) {
+                    statements.push_back(start);
+                }
+            }
+            if (statements.empty()) break;
+            size_t start = statements[rng() % statements.size()];
+            size_t end = min(text.find('\n', start), text.length() - 1) + 1;
+            inserted.clear();
+            return {start, end - start, inserted};
+        }
+        case 3: {
+            // A procedure added before another, or before wain
+            vector<size_t> procedures = lineStarts(text, "int ");
+            if (procedures.empty()) break;
+            inserted = procedureText(rng, "q" + to_string(rng() % 1000));
+            return {procedures[rng() % procedures.size()], 0, inserted};
+        }
+        default:
+            break;
+    }
+    // Bytes cut anywhere, a snippet pasted in their place
+    size_t offset = rng() % (text.length() + 1);
+    size_t removed = rng() % (min<size_t>(text.length() - offset, 24) + 1);
+    inserted = SNIPPETS[rng() % size(SNIPPETS)];
+    return {offset, removed, inserted};
+}
+
+bool sameTokens(const vector<Token>& a, const vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].kind != b[i].kind || a[i].offset != b[i].offset || a[i].length != b[i].length) return false;
+    }
+    return true;
+}
+
+// The printed tree of tokens, reusing previous (with change, if given);
+// "" on a syntax error
+string parseTree(const string& text, const vector<Token>& tokens, const PreviousTree* previous,
+                 const TokenChange* change) {
+    WLP4Parser parser;
+    for (const Token& token : tokens) parser.addToken(token.kind, token.lexeme(text));
+    if (previous && change) parser.reuseFrom(*previous, *change);
+    if (!parser.parse()) return "";
+    ostringstream out;
+    parser.write(out);
+    return out.str();
+}
+
+int main(int argc, char* argv[]) {
+    size_t editCount = 20000;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        string_view arg = argv[i];
+        if (arg == "--edits" && i + 1 < argc) {
+            editCount = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = strtoul(argv[++i], nullptr, 10);
+        } else {
+            cerr << "ERROR: unknown option " << arg << endl;
+            return 1;
+        }
+    }
+
+    // The parser reports syntax errors on cerr, which are expected here
+    ostringstream parseErrors;
+    streambuf* errors = cerr.rdbuf(parseErrors.rdbuf());
+
+    mt19937 rng(seed);
+    size_t edits = 0, lexErrors = 0, parsed = 0, reparsed = 0;
+    while (edits < editCount) {
+        string text = randomProgram(rng);
+        vector<Token> tokens;
+        scanTokens(text, tokens);
+        string tree = parseTree(text, tokens, nullptr, nullptr);
+        for (int step = 0; step < EDITS_PER_PROGRAM && edits < editCount; ++step, ++edits) {
+            string inserted;
+            SourceEdit edit = randomEdit(rng, text, tokens, inserted);
+            string before = text;
+            vector<Token> oldTokens = tokens;
+            TokenChange change;
+            bool ok = relexEdit(text, tokens, edit, change);
+
+            vector<Token> expected;
+            bool expectedOk = scanTokens(text, expected);
+            bool sameTail = oldTokens.size() - change.oldEnd == tokens.size() - change.newEnd;
+            if (ok != expectedOk || !sameTokens(tokens, expected) || (ok && !sameTail)) {
+                cerr.rdbuf(errors);
+                cerr << "FAILED: relexEdit at " << edit.offset << " removing " << edit.removed << " inserting \""
+                     << inserted << "\" (seed " << seed << ", edit " << edits << ") on:\n" << before << endl;
+                return 1;
+            }
+            if (!ok) {
+                lexErrors++;
+                break;  // the tokens stop at the error, so start over
+            }
+
+            string expectedTree = parseTree(text, tokens, nullptr, nullptr);
+            if (!tree.empty()) {
+                PreviousTree previous;
+                istringstream in(tree);
+                previous.read(in);
+                if (parseTree(text, tokens, &previous, &change) != expectedTree) {
+                    cerr.rdbuf(errors);
+                    cerr << "FAILED: reuse after the edit at " << edit.offset << " removing " << edit.removed
+                         << " inserting \"" << inserted << "\" (seed " << seed << ", edit " << edits << ") on:\n"
+                         << before << endl;
+                    return 1;
+                }
+                reparsed++;
+            }
+            parsed += !expectedTree.empty();
+            tree = expectedTree;
+        }
+    }
+    cerr.rdbuf(errors);
+    cout << edits << " edits ok: " << lexErrors << " lexical errors, " << parsed << " parsed, " << reparsed
+         << " reparsed reusing the tree before" << endl;
+    return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef WLP4INPUT_H
+#define WLP4INPUT_H
+
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Reads all of a stream into one buffer; used when the input cannot be mapped
+inline std::string readAll(int fd) {
+  std::string buffer;
+  size_t size = 0;
+  buffer.resize(1 << 16);
+  while (true) {
+    ssize_t got = read(fd, &buffer[size], buffer.size() - size);
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) break;
+    size += got;
+    if (size == buffer.size()) buffer.resize(buffer.size() * 2);
+  }
+  buffer.resize(size);
+  return buffer;
+}
+
+// A whole input: a read-only mapping of a regular file, or a copy of a pipe
+class SourceBuffer {
+  const char* mapped = nullptr;
+  size_t mappedSize = 0;
+  std::string streamed;
+
+public:
+  explicit SourceBuffer(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+      void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, info.st_size, MADV_SEQUENTIAL);
+        mapped = static_cast<const char*>(addr);
+        mappedSize = info.st_size;
+        return;
+      }
+    }
+    streamed = readAll(fd);
+  }
+
+  ~SourceBuffer() {
+    if (mapped) munmap(const_cast<char*>(mapped), mappedSize);
+  }
+
+  SourceBuffer(const SourceBuffer&) = delete;
+  SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+  std::string_view view() const {
+    return mapped ? std::string_view(mapped, mappedSize) : std::string_view(streamed);
+  }
+};
+
+#endif
@@ -0,0 +1,603 @@
+#ifndef WLP4LEX_H
+#define WLP4LEX_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+#include "wlp4token.h"
+
+// WLP4 scanner core: the DFA compiled to a dense table, SIMD run skipping,
+// and maximal-munch scanning of an in-memory buffer into Token slices.
+
+constexpr std::string_view ALPHABET    = ".ALPHABET";
+constexpr std::string_view STATES      = ".STATES";
+constexpr std::string_view TRANSITIONS = ".TRANSITIONS";
+constexpr std::string_view INPUT       = ".INPUT";
+constexpr std::string_view EMPTY       = ".EMPTY";
+
+// Embedded WLP4 DFA
+constexpr std::string_view wlp4_dfa_string = R"(.ALPHABET
+a-z A-Z 0-9 ( ) { } = ! < > + - * / % , ; [ ] &
+.STATES
+start
+alpha! id!
+zero! nonZeroDigit! dec!
+lparen! rparen! lbrace! rbrace!
+equals! becomes! eq!
+exclamation ne!
+less! lt! le!
+greater! gt! ge!
+plus! minus! star! slashStart! pct! comma! semi!
+lbrack! rbrack! amp!
+.TRANSITIONS
+start a-z A-Z alpha
+start 0 zero
+start 1-9 nonZeroDigit
+start ( lparen
+start ) rparen
+start { lbrace
+start } rbrace
+start = equals
+start ! exclamation
+start < less
+start > greater
+start + plus
+start - minus
+start * star
+start / slashStart
+start % pct
+start , comma
+start ; semi
+start [ lbrack
+start ] rbrack
+start & amp
+alpha a-z A-Z 0-9 id
+id a-z A-Z 0-9 id
+nonZeroDigit 0-9 dec
+dec 0-9 dec
+equals = eq
+exclamation = ne
+less = le
+greater = ge
+.INPUT
+)";
+
+// Token kind produced when the DFA stops in each accepting state
+struct StateKind {
+  std::string_view state;
+  TokenKind kind;
+};
+
+constexpr StateKind STATE_KINDS[] = {
+  {"alpha", TK_ID}, {"id", TK_ID},
+  {"zero", TK_NUM}, {"nonZeroDigit", TK_NUM}, {"dec", TK_NUM},
+  {"lparen", TK_LPAREN}, {"rparen", TK_RPAREN},
+  {"lbrace", TK_LBRACE}, {"rbrace", TK_RBRACE},
+  {"equals", TK_BECOMES}, {"becomes", TK_BECOMES}, {"eq", TK_EQ}, {"ne", TK_NE},
+  {"less", TK_LT}, {"lt", TK_LT}, {"greater", TK_GT}, {"gt", TK_GT},
+  {"le", TK_LE}, {"ge", TK_GE},
+  {"plus", TK_PLUS}, {"minus", TK_MINUS}, {"star", TK_STAR},
+  {"slashStart", TK_SLASH}, {"pct", TK_PCT},
+  {"comma", TK_COMMA}, {"semi", TK_SEMI},
+  {"lbrack", TK_LBRACK}, {"rbrack", TK_RBRACK}, {"amp", TK_AMP}
+};
+
+constexpr int MAX_DFA_STATES = 64;
+constexpr uint8_t NO_STATE = 0xFF;
+
+// Dense form of the DFA: integer state IDs, one row of 256 successors per state
+struct CompiledDFA {
+  uint8_t next[MAX_DFA_STATES][256] = {};
+  TokenKind accept[MAX_DFA_STATES] = {};  // TK_NONE for non-accepting states
+  bool alnumLoop[MAX_DFA_STATES] = {};    // state loops on [A-Za-z0-9] and nothing else
+  std::string_view names[MAX_DFA_STATES] = {};
+  uint8_t start = 0;
+  int stateCount = 0;
+};
+
+constexpr bool isChar(std::string_view s) {
+  return s.length() == 1;
+}
+
+constexpr bool isRange(std::string_view s) {
+  return s.length() == 3 && s[1] == '-';
+}
+
+constexpr bool isAlnum(int c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+constexpr bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Splits the DFA text into lines and whitespace-separated words at compile time
+struct SpecReader {
+  std::string_view text;
+  size_t pos = 0;
+
+  constexpr bool nextLine(std::string_view& line) {
+    if (pos >= text.length()) return false;
+    size_t end = text.find('\n', pos);
+    if (end == std::string_view::npos) end = text.length();
+    line = text.substr(pos, end - pos);
+    pos = end + 1;
+    return true;
+  }
+};
+
+constexpr bool nextWord(std::string_view& line, std::string_view& word) {
+  size_t i = 0;
+  while (i < line.length() && isBlank(line[i])) ++i;
+  if (i == line.length()) return false;
+  size_t j = i;
+  while (j < line.length() && !isBlank(line[j])) ++j;
+  word = line.substr(i, j - i);
+  line = line.substr(j);
+  return true;
+}
+
+constexpr TokenKind stateKind(std::string_view state) {
+  for (const StateKind& entry : STATE_KINDS) {
+    if (entry.state == state) return entry.kind;
+  }
+  return TK_NONE;
+}
+
+constexpr CompiledDFA compileDFA(std::string_view spec) {
+  CompiledDFA dfa;
+  std::string_view* names = dfa.names;
+  for (int i = 0; i < MAX_DFA_STATES; ++i) {
+    for (int c = 0; c < 256; ++c) dfa.next[i][c] = NO_STATE;
+  }
+
+  auto stateId = [&](std::string_view name) -> uint8_t {
+    for (int i = 0; i < dfa.stateCount; ++i) {
+      if (names[i] == name) return static_cast<uint8_t>(i);
+    }
+    throw "transition refers to an undeclared DFA state";
+  };
+
+  SpecReader in{spec};
+  std::string_view line, word;
+  in.nextLine(line); // Alphabet section (skip header)
+  // The alphabet itself is implied by the transitions
+  while (in.nextLine(line) && line != STATES) {}
+
+  // Read states separated by whitespace; the first one is initial
+  while (in.nextLine(line) && line != TRANSITIONS) {
+    while (nextWord(line, word)) {
+      bool accepting = false;
+      if (word.back() == '!' && !isChar(word)) {
+        accepting = true;
+        word.remove_suffix(1);
+      }
+      if (dfa.stateCount == MAX_DFA_STATES) throw "too many DFA states";
+      names[dfa.stateCount] = word;
+      if (accepting) {
+        dfa.accept[dfa.stateCount] = stateKind(word);
+        if (dfa.accept[dfa.stateCount] == TK_NONE) throw "accepting state has no token kind";
+      }
+      ++dfa.stateCount;
+    }
+  }
+
+  // Read transitions line-by-line: fromState symbols... toState
+  while (in.nextLine(line) && line != INPUT) {
+    std::string_view words[64] = {};
+    int count = 0;
+    while (count < 64 && nextWord(line, word)) words[count++] = word;
+    if (count < 3) continue;
+    uint8_t fromState = stateId(words[0]);
+    uint8_t toState = stateId(words[count - 1]);
+    for (int i = 1; i < count - 1; ++i) {
+      std::string_view s = words[i];
+      if (isChar(s)) {
+        dfa.next[fromState][static_cast<unsigned char>(s[0])] = toState;
+      } else if (isRange(s)) {
+        for (int c = static_cast<unsigned char>(s[0]); c <= static_cast<unsigned char>(s[2]); ++c) {
+          dfa.next[fromState][c] = toState;
+        }
+      }
+    }
+  }
+
+  // Mark the states a whole [A-Za-z0-9] run can be skipped through at once
+  for (int i = 0; i < dfa.stateCount; ++i) {
+    bool loop = true;
+    for (int c = 0; c < 256 && loop; ++c) {
+      loop = (dfa.next[i][c] == i) == isAlnum(c) && (isAlnum(c) || dfa.next[i][c] == NO_STATE);
+    }
+    dfa.alnumLoop[i] = loop;
+  }
+  return dfa;
+}
+
+constexpr CompiledDFA WLP4_DFA = compileDFA(wlp4_dfa_string);
+
+// Kind of a lexeme the DFA accepted as `accepted`: identifiers may be keywords
+inline TokenKind getTokenType(TokenKind accepted, std::string_view lexeme) {
+  if (accepted == TK_ID) {
+    return classifyIdentifier(lexeme);
+  }
+  return accepted;
+}
+
+// NUM lexemes never have leading zeros, so the length alone decides
+// everything except the 10-digit case, which compares against INT_MAX.
+inline bool isValidNumber(std::string_view numStr) {
+  constexpr std::string_view INT_MAX_DIGITS = "2147483647";
+  if (numStr.length() != INT_MAX_DIGITS.length()) {
+    return numStr.length() < INT_MAX_DIGITS.length();
+  }
+  return numStr <= INT_MAX_DIGITS;
+}
+
+// Run-skipping kernels. Each returns the first position at or after pos
+// (and before n) that does not continue the run, or n.
+struct ScanKernels {
+  size_t (*skipBlanks)(const unsigned char* s, size_t pos, size_t n);   // ' ' '\t' '\n'
+  size_t (*skipAlnum)(const unsigned char* s, size_t pos, size_t n);    // [A-Za-z0-9]
+  size_t (*findNewline)(const unsigned char* s, size_t pos, size_t n);  // comment body
+};
+
+inline size_t skipBlanksScalar(const unsigned char* s, size_t pos, size_t n) {
+  while (pos < n && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n')) pos++;
+  return pos;
+}
+
+inline size_t skipAlnumScalar(const unsigned char* s, size_t pos, size_t n) {
+  while (pos < n && isAlnum(s[pos])) pos++;
+  return pos;
+}
+
+inline size_t findNewlineScalar(const unsigned char* s, size_t pos, size_t n) {
+  const void* newline = std::memchr(s + pos, '\n', n - pos);
+  return newline ? static_cast<const unsigned char*>(newline) - s : n;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WLP4_SCAN_X86 1
+
+// Signed byte compares are safe for these ranges: bytes >= 0x80 are
+// negative and therefore never fall inside an ASCII range.
+__attribute__((target("sse2")))
+inline __m128i alnumMask128(__m128i v) {
+  __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                 _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+  return _mm_or_si128(letter, digit);
+}
+
+__attribute__((target("sse2")))
+inline __m128i blankMask128(__m128i v) {
+  return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                   _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                      _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+}
+
+__attribute__((target("sse2")))
+inline size_t skipBlanksSSE2(const unsigned char* s, size_t pos, size_t n) {
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pos));
+    unsigned stop = ~_mm_movemask_epi8(blankMask128(v)) & 0xFFFF;
+    if (stop) return pos + __builtin_ctz(stop);
+  }
+  return skipBlanksScalar(s, pos, n);
+}
+
+__attribute__((target("sse2")))
+inline size_t skipAlnumSSE2(const unsigned char* s, size_t pos, size_t n) {
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pos));
+    unsigned stop = ~_mm_movemask_epi8(alnumMask128(v)) & 0xFFFF;
+    if (stop) return pos + __builtin_ctz(stop);
+  }
+  return skipAlnumScalar(s, pos, n);
+}
+
+__attribute__((target("sse2")))
+inline size_t findNewlineSSE2(const unsigned char* s, size_t pos, size_t n) {
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pos));
+    unsigned hit = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+    if (hit) return pos + __builtin_ctz(hit);
+  }
+  return findNewlineScalar(s, pos, n);
+}
+
+__attribute__((target("avx2")))
+inline __m256i alnumMask256(__m256i v) {
+  __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+  __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                    _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+  __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                   _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+  return _mm256_or_si256(letter, digit);
+}
+
+__attribute__((target("avx2")))
+inline __m256i blankMask256(__m256i v) {
+  return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                         _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                         _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+}
+
+__attribute__((target("avx2")))
+inline size_t skipBlanksAVX2(const unsigned char* s, size_t pos, size_t n) {
+  for (; pos + 32 <= n; pos += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos));
+    unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(blankMask256(v)));
+    if (stop) return pos + __builtin_ctz(stop);
+  }
+  return skipBlanksSSE2(s, pos, n);
+}
+
+__attribute__((target("avx2")))
+inline size_t skipAlnumAVX2(const unsigned char* s, size_t pos, size_t n) {
+  for (; pos + 32 <= n; pos += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos));
+    unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(alnumMask256(v)));
+    if (stop) return pos + __builtin_ctz(stop);
+  }
+  return skipAlnumSSE2(s, pos, n);
+}
+
+__attribute__((target("avx2")))
+inline size_t findNewlineAVX2(const unsigned char* s, size_t pos, size_t n) {
+  for (; pos + 32 <= n; pos += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pos));
+    unsigned hit = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))));
+    if (hit) return pos + __builtin_ctz(hit);
+  }
+  return findNewlineSSE2(s, pos, n);
+}
+#endif
+
+// Picks the widest kernels the CPU supports, once per process
+inline const ScanKernels& scanKernels() {
+  static const ScanKernels kernels = [] {
+#ifdef WLP4_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return ScanKernels{skipBlanksAVX2, skipAlnumAVX2, findNewlineAVX2};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+      return ScanKernels{skipBlanksSSE2, skipAlnumSSE2, findNewlineSSE2};
+    }
+#endif
+    return ScanKernels{skipBlanksScalar, skipAlnumScalar, findNewlineScalar};
+  }();
+  return kernels;
+}
+
+// A token is a slice of the input buffer; it owns no memory
+struct Token {
+  TokenKind kind;
+  uint32_t offset;
+  uint32_t length;
+
+  std::string_view lexeme(std::string_view input) const {
+    return input.substr(offset, length);
+  }
+};
+
+// Where a scan of a block that the input continues past had to stop: the
+// start of a token or "//" that may run into the next block, or the block
+// end if it stopped inside a comment that continues to the next newline.
+struct ScanStop {
+  size_t pos;
+  bool inComment;
+};
+
+// Runs the dense-table DFA from pos until it is stuck: no arrow out of the
+// current state on the next character. Returns where it stopped and sets
+// the token kind the final state accepts (TK_NONE if it does not). Inside
+// an identifier the rest of the [A-Za-z0-9] run is taken at once.
+struct TableMatcher {
+  const ScanKernels& kernels = scanKernels();
+
+  size_t munch(const unsigned char* s, size_t pos, size_t n, TokenKind& kind) const {
+    uint8_t p = WLP4_DFA.start;
+    while (pos < n) {
+      uint8_t q = WLP4_DFA.next[p][s[pos]];
+      if (q == NO_STATE) break;
+      p = q;
+      pos++;
+      if (WLP4_DFA.alnumLoop[p]) {
+        pos = kernels.skipAlnum(s, pos, n);
+        break;
+      }
+    }
+    kind = WLP4_DFA.accept[p];
+    return pos;
+  }
+};
+
+// Building with -DWLP4_DIRECT_LEXER swaps in the direct-coded DFA that
+// wlp4lexgen generates. It sets the accepted kinds itself, so it can also
+// come from a spec file other than the embedded one:
+//   g++ -std=c++17 -o wlp4lexgen wlp4lexgen.cc && ./wlp4lexgen > wlp4lexdirect.h
+#ifdef WLP4_DIRECT_LEXER
+#include "wlp4lexdirect.h"
+using ScanMatcher = DirectMatcher;
+#else
+using ScanMatcher = TableMatcher;
+#endif
+
+// Maximal-munch scan of input[begin, limit). Appends tokens in order and
+// returns false at the first lexical error (tokens before it are kept).
+// The range must start on a line boundary. When `stop` is null the range
+// also ends on one; otherwise the input continues past `limit` and nothing
+// that could still grow is scanned. Matcher is the DFA core to run; the
+// default is the one the build selects above.
+template <typename Matcher = ScanMatcher>
+inline bool scanRange(std::string_view input, size_t begin, size_t limit, std::vector<Token>& tokens,
+               ScanStop* stop = nullptr) {
+  const unsigned char* s = reinterpret_cast<const unsigned char*>(input.data());
+  const size_t n = limit;
+  size_t pos = begin;
+
+  const ScanKernels& kernels = scanKernels();
+  const Matcher matcher{};
+
+  while (pos < n) {
+    unsigned char c = s[pos];
+
+    // Skip whitespace; newlines only separate tokens
+    if (c == ' ' || c == '\t' || c == '\n') {
+      pos = kernels.skipBlanks(s, pos + 1, n);
+      continue;
+    }
+
+    // Check for comments: skip rest of line
+    if (c == '/' && pos + 1 < n && s[pos + 1] == '/') {
+      pos = kernels.findNewline(s, pos + 2, n);
+      if (stop && pos == n) {
+        *stop = {n, true};
+        return true;
+      }
+      continue;
+    }
+    if (stop && c == '/' && pos + 1 == n) break;
+
+    TokenKind accepted;
+    size_t end = matcher.munch(s, pos, n, accepted);
+    if (stop && end == n) break;
+
+    if (accepted == TK_NONE) return false;
+
+    std::string_view lexeme = input.substr(pos, end - pos);
+    TokenKind kind = getTokenType(accepted, lexeme);
+
+    // Check numeric range for NUM tokens
+    if (kind == TK_NUM && !isValidNumber(lexeme)) return false;
+
+    tokens.push_back({kind, static_cast<uint32_t>(pos), static_cast<uint32_t>(end - pos)});
+    pos = end;
+  }
+  if (stop) *stop = {pos, false};
+  return true;
+}
+
+inline bool scanTokens(std::string_view input, std::vector<Token>& tokens) {
+  return scanRange(input, 0, input.length(), tokens);
+}
+
+// Inputs smaller than this are not worth splitting across threads
+constexpr size_t MIN_PARALLEL_CHUNK = 1 << 20;
+
+// Scans the input on `threads` workers. Tokens never span a newline and a
+// comment ends at one, so chunks cut just after a newline scan independently;
+// the per-chunk results are then joined in order, stopping at the first error.
+inline bool scanTokensParallel(std::string_view input, unsigned threads, std::vector<Token>& tokens) {
+  size_t chunkCount = std::min<size_t>(threads * 4, input.length() / MIN_PARALLEL_CHUNK);
+  if (threads <= 1 || chunkCount <= 1) {
+    return scanTokens(input, tokens);
+  }
+
+  std::vector<size_t> bounds = {0};
+  for (size_t i = 1; i < chunkCount; ++i) {
+    size_t cut = std::max(bounds.back(), input.length() / chunkCount * i);
+    size_t newline = input.find('\n', cut);
+    if (newline == std::string_view::npos) break;
+    if (newline + 1 > bounds.back()) bounds.push_back(newline + 1);
+  }
+  bounds.push_back(input.length());
+  chunkCount = bounds.size() - 1;
+
+  std::vector<std::vector<Token>> results(chunkCount);
+  std::vector<char> chunkOk(chunkCount, 0);
+  std::atomic<size_t> nextChunk{0};
+  auto worker = [&] {
+    for (size_t i; (i = nextChunk++) < chunkCount;) {
+      chunkOk[i] = scanRange(input, bounds[i], bounds[i + 1], results[i]);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < std::min<size_t>(threads, chunkCount); ++t) {
+    pool.emplace_back(worker);
+  }
+  for (std::thread& thread : pool) thread.join();
+
+  size_t total = 0;
+  for (const std::vector<Token>& chunk : results) total += chunk.size();
+  tokens.reserve(tokens.size() + total);
+  for (size_t i = 0; i < chunkCount; ++i) {
+    tokens.insert(tokens.end(), results[i].begin(), results[i].end());
+    if (!chunkOk[i]) return false;
+  }
+  return true;
+}
+
+// An edit to source text: `removed` bytes at `offset` replaced by `inserted`
+struct SourceEdit {
+  size_t offset;
+  size_t removed;
+  std::string_view inserted;
+};
+
+// Tokens an edit replaced: old tokens [first, oldEnd) became [first, newEnd)
+struct TokenChange {
+  size_t first;
+  size_t oldEnd;
+  size_t newEnd;
+};
+
+// Applies `edit` to `text` and splices `tokens`, which must be the complete
+// scan of the old text. Lines are re-lexed from the one containing the edit
+// until a line start past the edited bytes: the text after it is unchanged
+// and scanning restarts cleanly at every line, so from there on the old
+// tokens (shifted by the size change) are the new ones. Returns false on a
+// lexical error in the re-lexed lines; tokens then stop at the error, as
+// with scanTokens, and the next edit needs a full scan.
+inline bool relexEdit(std::string& text, std::vector<Token>& tokens, const SourceEdit& edit,
+                      TokenChange& change) {
+  size_t lineStart = edit.offset == 0 ? 0 : text.rfind('\n', edit.offset - 1) + 1;
+  auto byOffset = [](const Token& token, size_t offset) { return token.offset < offset; };
+  size_t first = std::lower_bound(tokens.begin(), tokens.end(), lineStart, byOffset) - tokens.begin();
+
+  text.replace(edit.offset, edit.removed, edit.inserted);
+  const size_t editEnd = edit.offset + edit.inserted.length();
+  const int64_t delta = static_cast<int64_t>(edit.inserted.length()) - static_cast<int64_t>(edit.removed);
+
+  // Re-lex whole lines until one ends past the edit (or the text ends)
+  std::vector<Token> fresh;
+  size_t pos = lineStart;
+  while (pos < text.length() && pos <= editEnd) {
+    size_t newline = text.find('\n', pos);
+    size_t next = newline == std::string::npos ? text.length() : newline + 1;
+    if (!scanRange(text, pos, next, fresh)) {
+      size_t oldCount = tokens.size();
+      tokens.resize(first);
+      tokens.insert(tokens.end(), fresh.begin(), fresh.end());
+      change = {first, oldCount, tokens.size()};
+      return false;
+    }
+    pos = next;
+  }
+
+  // pos is now a line start whose text matches the old text at pos - delta
+  size_t oldEnd = std::lower_bound(tokens.begin() + first, tokens.end(),
+                                   static_cast<size_t>(pos - delta), byOffset) - tokens.begin();
+  for (size_t i = oldEnd; i < tokens.size(); ++i) {
+    tokens[i].offset = static_cast<uint32_t>(tokens[i].offset + delta);
+  }
+  tokens.erase(tokens.begin() + first, tokens.begin() + oldEnd);
+  tokens.insert(tokens.begin() + first, fresh.begin(), fresh.end());
+  change = {first, oldEnd, first + fresh.size()};
+  return true;
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "wlp4lex.h"
+
+// Generates wlp4lexdirect.h: the scanner DFA as direct-coded C++, one
+// labelled block per state with a switch on the next byte, in the style
+// of re2c. Each state that stops the match sets the token kind it accepts
+// (TK_NONE if it does not), so the scanner needs nothing from WLP4_DFA and
+// a spec other than the embedded one tokenizes by its own states.
+//
+// Usage: wlp4lexgen [spec-file] > wlp4lexdirect.h
+// The spec defaults to the embedded wlp4_dfa_string.
+
+std::string charLiteral(int c) {
+  if (c == '\'' || c == '\\') return std::string("'\\") + static_cast<char>(c) + "'";
+  if (c >= 0x20 && c < 0x7F) return std::string("'") + static_cast<char>(c) + "'";
+  std::ostringstream out;
+  out << "0x" << std::hex << c;
+  return out.str();
+}
+
+// The enumerator naming kind in the generated code
+std::string kindName(TokenKind kind) {
+  if (kind == TK_NONE) return "TK_NONE";
+  return "TK_" + std::string(TOKEN_KIND_NAMES[kind]);
+}
+
+void emitState(std::ostream& out, const CompiledDFA& dfa, int state) {
+  out << "  state" << state << ":  // " << dfa.names[state] << "\n";
+  std::string stop = "kind = " + kindName(dfa.accept[state]) + ";\n";
+
+  // Group the bytes by successor, in order of first byte
+  std::vector<int> targets;
+  for (int c = 0; c < 256; ++c) {
+    uint8_t to = dfa.next[state][c];
+    if (to == NO_STATE) continue;
+    bool seen = false;
+    for (int t : targets) seen = seen || t == to;
+    if (!seen) targets.push_back(to);
+  }
+
+  if (targets.empty()) {
+    out << "    " << stop;
+    out << "    return pos;\n";
+    return;
+  }
+
+  out << "    if (pos == n) {\n";
+  out << "      " << stop;
+  out << "      return pos;\n";
+  out << "    }\n";
+  out << "    switch (s[pos]) {\n";
+  for (int to : targets) {
+    int onLine = 0;
+    for (int c = 0; c < 256; ++c) {
+      if (dfa.next[state][c] != to) continue;
+      out << (onLine == 0 ? "      " : " ") << "case " << charLiteral(c) << ":";
+      if (++onLine == 8) {
+        out << "\n";
+        onLine = 0;
+      }
+    }
+    if (onLine != 0) out << "\n";
+    out << "        ++pos;\n";
+    out << "        goto state" << to << ";\n";
+  }
+  out << "      default:\n";
+  out << "        " << stop;
+  out << "        return pos;\n";
+  out << "    }\n";
+}
+
+int main(int argc, char* argv[]) {
+  std::string spec(wlp4_dfa_string);
+  if (argc > 1) {
+    std::ifstream in(argv[1]);
+    if (!in) {
+      std::cerr << "ERROR: cannot open " << argv[1] << std::endl;
+      return 1;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    spec = text.str();
+  }
+
+  CompiledDFA dfa;
+  try {
+    dfa = compileDFA(spec);
+  } catch (const char* message) {
+    std::cerr << "ERROR: " << message << std::endl;
+    return 1;
+  }
+
+  // Only states something can reach get a label
+  std::vector<bool> reachable(dfa.stateCount, false);
+  reachable[dfa.start] = true;
+  for (int i = 0; i < dfa.stateCount; ++i) {
+    for (int c = 0; c < 256; ++c) {
+      if (dfa.next[i][c] != NO_STATE) reachable[dfa.next[i][c]] = true;
+    }
+  }
+
+  std::ostream& out = std::cout;
+  out << "// Generated by wlp4lexgen from the WLP4 DFA spec. Do not edit.\n";
+  out << "#ifndef WLP4LEXDIRECT_H\n";
+  out << "#define WLP4LEXDIRECT_H\n\n";
+  out << "#include <cstddef>\n";
+  out << "#include \"wlp4token.h\"\n\n";
+  out << "// Direct-coded counterpart of TableMatcher: runs the DFA from pos until it\n";
+  out << "// is stuck, returns where it stopped and sets the token kind accepted there.\n";
+  out << "struct DirectMatcher {\n";
+  out << "  size_t munch(const unsigned char* s, size_t pos, size_t n, TokenKind& kind) const {\n";
+  out << "    goto state" << static_cast<int>(dfa.start) << ";\n";
+  for (int i = 0; i < dfa.stateCount; ++i) {
+    if (reachable[i]) emitState(out, dfa, i);
+  }
+  out << "  }\n";
+  out << "};\n\n";
+  out << "#endif\n";
+  return 0;
+}
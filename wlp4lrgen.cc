@@ -0,0 +1,340 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <deque>
+#include <cstdint>
+#include "wlp4grammar.h"
+
+// Builds the LALR(1) (or, with --lr1, canonical LR(1)) automaton for a WLP4
+// CFG and writes it in the .CFG/.TRANSITIONS/.REDUCTIONS text form that
+// wlp4grammar.h compiles, or with --header as wlp4lrtables.h for
+// -DWLP4_GENERATED_TABLES builds. State, conflict and table density
+// counts go to stderr.
+//
+// Usage: wlp4lrgen [--lr1] [--header | --stats] [cfg-file]
+// The CFG defaults to the embedded WLP4_CFG; a file may hold a whole
+// combined grammar, of which only the .CFG section is read. The header
+// records its state count as WLP4_GENERATED_STATE_COUNT, which sizes the
+// tables of the build that includes it, so the 400-state --lr1 automaton
+// works there too (the packed size is only printed up to MAX_LR_STATES).
+
+// Lookahead sets are bitmasks over symbol IDs; bit 0 (TK_NONE) stands for
+// the end of input, which the text form writes as ".ACCEPT"
+using Lookaheads = uint64_t;
+constexpr Lookaheads END_OF_INPUT = 1;
+
+// An item core is (rule, dot) packed into one int
+constexpr int itemCore(int rule, int dot) {
+  return rule * (MAX_RHS + 1) + dot;
+}
+
+struct LRState {
+  std::map<int, Lookaheads> kernel;
+  std::map<int, Lookaheads> items;  // closure of kernel
+  std::map<int, int> transitions;    // symbol -> state
+};
+
+class AutomatonBuilder {
+  const ParseTables& grammar;
+  bool canonical;
+  std::vector<bool> nullable;
+  std::vector<Lookaheads> first;
+  std::map<std::vector<std::pair<int, Lookaheads>>, int> stateIds;
+  std::deque<int> pending;
+
+public:
+  std::vector<LRState> states;
+
+  AutomatonBuilder(const ParseTables& grammar, bool canonical)
+      : grammar(grammar), canonical(canonical),
+        nullable(grammar.symbolCount, false), first(grammar.symbolCount, 0) {
+    computeFirstSets();
+  }
+
+  void build() {
+    // The first rule is the start rule; its completion is the accept
+    addState({{itemCore(0, 0), END_OF_INPUT}});
+    while (!pending.empty()) {
+      int s = pending.front();
+      pending.pop_front();
+      expand(s);
+    }
+  }
+
+private:
+  bool isNonterminal(int symbol) const {
+    return symbol >= FIRST_NONTERMINAL;
+  }
+
+  void computeFirstSets() {
+    for (int symbol = 1; symbol < FIRST_NONTERMINAL; ++symbol) first[symbol] = Lookaheads(1) << symbol;
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int r = 0; r < grammar.ruleCount; ++r) {
+        const Production& rule = grammar.rules[r];
+        Lookaheads set = first[rule.lhs];
+        bool allNullable = true;
+        for (int i = 0; i < rule.length && allNullable; ++i) {
+          set |= first[rule.rhs[i]];
+          allNullable = nullable[rule.rhs[i]];
+        }
+        if (set != first[rule.lhs] || (allNullable && !nullable[rule.lhs])) {
+          first[rule.lhs] = set;
+          nullable[rule.lhs] = nullable[rule.lhs] || allNullable;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // FIRST of rule.rhs[from..], plus follow if all of it can derive nothing
+  Lookaheads firstOfTail(const Production& rule, int from, Lookaheads follow) const {
+    Lookaheads set = 0;
+    for (int i = from; i < rule.length; ++i) {
+      set |= first[rule.rhs[i]];
+      if (!nullable[rule.rhs[i]]) return set;
+    }
+    return set | follow;
+  }
+
+  void closure(LRState& state) const {
+    state.items = state.kernel;
+    std::vector<int> work;
+    for (const auto& item : state.items) work.push_back(item.first);
+    while (!work.empty()) {
+      int core = work.back();
+      work.pop_back();
+      const Production& rule = grammar.rules[core / (MAX_RHS + 1)];
+      int dot = core % (MAX_RHS + 1);
+      if (dot == rule.length || !isNonterminal(rule.rhs[dot])) continue;
+      Lookaheads lookaheads = firstOfTail(rule, dot + 1, state.items[core]);
+      for (int r = 0; r < grammar.ruleCount; ++r) {
+        if (grammar.rules[r].lhs != rule.rhs[dot]) continue;
+        Lookaheads& target = state.items[itemCore(r, 0)];
+        if ((target | lookaheads) != target) {
+          target |= lookaheads;
+          work.push_back(itemCore(r, 0));
+        }
+      }
+    }
+  }
+
+  // LALR(1) states are identified by their kernel cores alone, canonical
+  // LR(1) states by cores and lookaheads
+  std::vector<std::pair<int, Lookaheads>> stateKey(const std::map<int, Lookaheads>& kernel) const {
+    std::vector<std::pair<int, Lookaheads>> key;
+    for (const auto& item : kernel) key.push_back({item.first, canonical ? item.second : 0});
+    return key;
+  }
+
+  int addState(const std::map<int, Lookaheads>& kernel) {
+    auto key = stateKey(kernel);
+    auto it = stateIds.find(key);
+    if (it == stateIds.end()) {
+      int id = states.size();
+      states.emplace_back();
+      states[id].kernel = kernel;
+      stateIds[key] = id;
+      pending.push_back(id);
+      return id;
+    }
+
+    // Merge lookaheads into an existing LALR state; if that adds any, its
+    // successors have to be recomputed
+    LRState& state = states[it->second];
+    bool grew = false;
+    for (const auto& item : kernel) {
+      Lookaheads& target = state.kernel[item.first];
+      if ((target | item.second) != target) {
+        target |= item.second;
+        grew = true;
+      }
+    }
+    if (grew) pending.push_back(it->second);
+    return it->second;
+  }
+
+  void expand(int s) {
+    closure(states[s]);
+    std::map<int, std::map<int, Lookaheads>> successors;
+    for (const auto& item : states[s].items) {
+      const Production& rule = grammar.rules[item.first / (MAX_RHS + 1)];
+      int dot = item.first % (MAX_RHS + 1);
+      if (dot == rule.length) continue;
+      successors[rule.rhs[dot]][item.first + 1] |= item.second;
+    }
+    for (const auto& successor : successors) {
+      int target = addState(successor.second);
+      states[s].transitions[successor.first] = target;
+    }
+  }
+};
+
+struct Reduction {
+  int state;
+  int rule;
+  int symbol;  // TK_NONE for .ACCEPT
+};
+
+void writeSection(std::ostream& out, const ParseTables& grammar, const std::vector<LRState>& states,
+                  const std::vector<Reduction>& reductions) {
+  out << ".CFG\n";
+  for (int r = 0; r < grammar.ruleCount; ++r) out << grammar.rules[r].text << "\n";
+  out << ".TRANSITIONS\n";
+  for (size_t s = 0; s < states.size(); ++s) {
+    for (const auto& transition : states[s].transitions) {
+      out << s << " " << grammar.symbolNames[transition.first] << " " << transition.second << "\n";
+    }
+  }
+  out << ".REDUCTIONS\n";
+  for (const Reduction& reduction : reductions) {
+    out << reduction.state << " " << reduction.rule << " "
+        << (reduction.symbol == TK_NONE ? std::string_view(".ACCEPT") : grammar.symbolNames[reduction.symbol]) << "\n";
+  }
+}
+
+int main(int argc, char* argv[]) {
+  bool canonical = false;
+  bool header = false;
+  bool statsOnly = false;
+  const char* path = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "--lr1") {
+      canonical = true;
+    } else if (arg == "--header") {
+      header = true;
+    } else if (arg == "--stats") {
+      statsOnly = true;
+    } else {
+      path = argv[i];
+    }
+  }
+
+  std::string cfg(WLP4_CFG);
+  if (path) {
+    std::ifstream in(path);
+    if (!in) {
+      std::cerr << "ERROR: cannot open " << path << std::endl;
+      return 1;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    cfg = text.str();
+  }
+
+  static ParseTables grammar;
+  try {
+    readGrammar(grammar, cfg);
+  } catch (const char* message) {
+    std::cerr << "ERROR: " << message << std::endl;
+    return 1;
+  }
+  if (grammar.ruleCount == 0) {
+    std::cerr << "ERROR: empty grammar" << std::endl;
+    return 1;
+  }
+
+  AutomatonBuilder builder(grammar, canonical);
+  builder.build();
+  const std::vector<LRState>& states = builder.states;
+
+  // Reductions, and the conflicts between them and the shifts
+  std::vector<Reduction> reductions;
+  int shiftReduce = 0;
+  int reduceReduce = 0;
+  int shiftEntries = 0;
+  int gotoEntries = 0;
+  int terminals = 1;  // end of input
+  std::vector<bool> used(grammar.symbolCount, false);
+  for (int r = 0; r < grammar.ruleCount; ++r) {
+    for (int i = 0; i < grammar.rules[r].length; ++i) used[grammar.rules[r].rhs[i]] = true;
+  }
+  for (int symbol = 1; symbol < FIRST_NONTERMINAL; ++symbol) terminals += used[symbol];
+  int nonterminals = grammar.symbolCount - FIRST_NONTERMINAL;
+
+  for (size_t s = 0; s < states.size(); ++s) {
+    std::map<int, int> reducing;  // lookahead -> rule
+    for (const auto& item : states[s].items) {
+      int rule = item.first / (MAX_RHS + 1);
+      if (item.first % (MAX_RHS + 1) != grammar.rules[rule].length) continue;
+      for (int symbol = 0; symbol < grammar.symbolCount; ++symbol) {
+        if (!(item.second >> symbol & 1)) continue;
+        if (states[s].transitions.count(symbol)) ++shiftReduce;
+        if (reducing.count(symbol)) {
+          ++reduceReduce;
+          continue;
+        }
+        reducing[symbol] = rule;
+        reductions.push_back({static_cast<int>(s), rule, symbol});
+      }
+    }
+    for (const auto& transition : states[s].transitions) {
+      ++(transition.first >= FIRST_NONTERMINAL ? gotoEntries : shiftEntries);
+    }
+  }
+
+  int actionEntries = shiftEntries + reductions.size();
+  double actionCells = static_cast<double>(states.size()) * terminals;
+  double gotoCells = static_cast<double>(states.size()) * nonterminals;
+  std::cerr << (canonical ? "LR(1)" : "LALR(1)") << ": " << states.size() << " states, "
+            << grammar.ruleCount << " rules, " << terminals << " terminals (with end of input), "
+            << nonterminals << " nonterminals\n";
+  std::cerr << "conflicts: " << shiftReduce + reduceReduce << " (" << shiftReduce << " shift/reduce, "
+            << reduceReduce << " reduce/reduce)\n";
+  std::cerr << "ACTION: " << actionEntries << " of " << actionCells << " entries ("
+            << 100 * actionEntries / actionCells << "%), " << shiftEntries << " shifts, "
+            << reductions.size() << " reductions\n";
+  std::cerr << "GOTO: " << gotoEntries << " of " << gotoCells << " entries ("
+            << 100 * gotoEntries / gotoCells << "%)\n";
+  std::cerr << "dense int16_t table: " << states.size() * grammar.symbolCount * 2 << " bytes" << std::endl;
+
+  if (shiftReduce + reduceReduce > 0) {
+    std::cerr << "ERROR: grammar is not " << (canonical ? "LR(1)" : "LALR(1)") << std::endl;
+    return 1;
+  }
+  std::ostringstream text;
+  writeSection(text, grammar, states, reductions);
+  std::string sections = text.str();
+  size_t transitionsAt = sections.find(".TRANSITIONS\n");
+  size_t reductionsAt = sections.find(".REDUCTIONS\n");
+
+  // Size of the -DWLP4_PACKED_TABLES form of this automaton
+  if (states.size() <= MAX_LR_STATES) {
+    std::string_view view(sections);
+    static ParseTables tables;
+    tables = buildParseTables(view.substr(0, transitionsAt), view.substr(transitionsAt, reductionsAt - transitionsAt),
+                              view.substr(reductionsAt));
+    static PackedTables packed;
+    packed = packTables(tables);
+    std::cerr << "packed tables: " << packed.byteSize(tables.stateCount, nonterminals) << " bytes" << std::endl;
+  }
+
+  if (statsOnly) return 0;
+
+  if (!header) {
+    std::cout << sections << ".END\n";
+    return 0;
+  }
+
+  std::ostream& out = std::cout;
+  out << "// Generated by wlp4lrgen from the WLP4 CFG. Do not edit.\n";
+  out << "#ifndef WLP4LRTABLES_H\n";
+  out << "#define WLP4LRTABLES_H\n\n";
+  out << "#include <string_view>\n\n";
+  out << "// Bounds MAX_LR_STATES in the build that includes this\n";
+  out << "constexpr int WLP4_GENERATED_STATE_COUNT = " << states.size() << ";\n\n";
+  out << "constexpr std::string_view WLP4_GENERATED_CFG = R\"END("
+      << sections.substr(0, transitionsAt) << ")END\";\n\n";
+  out << "constexpr std::string_view WLP4_GENERATED_TRANSITIONS = R\"END("
+      << sections.substr(transitionsAt, reductionsAt - transitionsAt) << ")END\";\n\n";
+  out << "constexpr std::string_view WLP4_GENERATED_REDUCTIONS = R\"END("
+      << sections.substr(reductionsAt) << ")END\";\n\n";
+  out << "#endif\n";
+  return 0;
+}
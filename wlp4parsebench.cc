@@ -0,0 +1,311 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wlp4input.h"
+#include "wlp4lex.h"
+#include "wlp4parser.h"
+
+using namespace std;
+
+// Usage: wlp4parsebench [--rounds r] [file]   (reads WLP4 source; stdin when no file is given)
+// Scans the source once, then runs the LR automaton over its tokens with
+// each form of the parse tables, best of r rounds (5 by default):
+//   map     std::map of (state, symbol name) to action, reductions and
+//           transitions apart, as wlp4parse first held them
+//   dense   WLP4_PARSE_TABLES, one int16_t per state and symbol
+//   packed  the default reductions and comb vector of -DWLP4_PACKED_TABLES
+//   direct  the code wlp4parsegen generates, in builds with -DWLP4_DIRECT_PARSER
+// These only keep the state stack, so they time the table lookups and not
+// the tree; each prints the bytes its tables take (for the maps, what they
+// allocate; the direct parser has none) and has to reduce the same rules
+// as the others. Last comes the whole WLP4Parser::parse(), tree and all,
+// with the tables or code this build uses.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o wlp4parsebench wlp4parsebench.cc
+// (add -DWLP4_PACKED_TABLES for the last line to use the packed tables)
+// With the direct parser (wlp4parsegen > wlp4parsedirect.h first, see wlp4parser.h):
+//   g++ -std=c++17 -O2 -pthread -DWLP4_DIRECT_PARSER -o wlp4parsebench wlp4parsebench.cc
+
+// Runs the automaton without building anything: the state stack, and a
+// hash of the rules reduced in order to compare runs by
+struct Recognizer {
+    const vector<int>& symbols;
+    size_t index = 0;
+    vector<int> states;
+    uint64_t trace = 0;
+
+    explicit Recognizer(const vector<int>& symbols) : symbols(symbols), states{0} {
+        states.reserve(1024);
+    }
+
+    int lookahead() const { return symbols[index]; }
+    int top() const { return states.back(); }
+    void push(int state) { states.push_back(state); }
+
+    void shift(int state) {
+        states.push_back(state);
+        ++index;
+    }
+
+    void reduce(int rule) {
+        states.resize(states.size() - WLP4_PARSE_TABLES.rules[rule].length);
+        trace = trace * 31 + rule + 1;
+    }
+
+    bool accept() {
+        trace = trace * 31 + WLP4_PARSE_TABLES.acceptRule + 1;
+        return true;
+    }
+
+    bool error() { return false; }
+};
+
+struct DenseForm {
+    int16_t action(int state, int symbol) const {
+        return WLP4_PARSE_TABLES.action[state][symbol];
+    }
+
+    int gotoState(int state, int nonterminal) const {
+        return WLP4_PARSE_TABLES.action[state][nonterminal];
+    }
+
+    size_t byteSize() const {
+        return WLP4_PARSE_TABLES.stateCount * sizeof(WLP4_PARSE_TABLES.action[0]);
+    }
+};
+
+constexpr PackedTables BENCH_PACKED_TABLES = packTables(WLP4_PARSE_TABLES);
+
+struct PackedForm {
+    int16_t action(int state, int symbol) const {
+        return BENCH_PACKED_TABLES.action(state, symbol);
+    }
+
+    int gotoState(int state, int nonterminal) const {
+        return BENCH_PACKED_TABLES.gotoState[state][nonterminal - FIRST_NONTERMINAL];
+    }
+
+    size_t byteSize() const {
+        return BENCH_PACKED_TABLES.byteSize(WLP4_PARSE_TABLES.stateCount,
+                                            WLP4_PARSE_TABLES.symbolCount - FIRST_NONTERMINAL);
+    }
+};
+
+// Bytes the map tables hold on the heap
+size_t mapBytes = 0;
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        mapBytes += n * sizeof(T);
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        mapBytes -= n * sizeof(T);
+        ::operator delete(p);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+using ActionKey = pair<int, string_view>;
+using ActionMap = map<ActionKey, int16_t, less<ActionKey>, CountingAllocator<pair<const ActionKey, int16_t>>>;
+
+struct MapForm {
+    ActionMap reductions;
+    ActionMap transitions;  // shifts and gotos
+
+    MapForm() {
+        const ParseTables& tables = WLP4_PARSE_TABLES;
+        for (int state = 0; state < tables.stateCount; ++state) {
+            for (int symbol = 0; symbol < tables.symbolCount; ++symbol) {
+                int16_t action = tables.action[state][symbol];
+                if (action == 0) continue;
+                (isReduce(action) ? reductions : transitions)[{state, tables.symbolNames[symbol]}] = action;
+            }
+        }
+    }
+
+    int16_t action(int state, int symbol) const {
+        ActionKey key{state, WLP4_PARSE_TABLES.symbolNames[symbol]};
+        auto it = reductions.find(key);
+        if (it != reductions.end()) return it->second;
+        it = transitions.find(key);
+        return it == transitions.end() ? 0 : it->second;
+    }
+
+    int gotoState(int state, int nonterminal) const {
+        return transitions.find({state, WLP4_PARSE_TABLES.symbolNames[nonterminal]})->second;
+    }
+
+    size_t byteSize() const {
+        return mapBytes;
+    }
+};
+
+template <typename Form>
+const Form& tableForm() {
+    static const Form form;
+    return form;
+}
+
+// The table-driven loop of WLP4Parser::parse() over one form of the tables
+template <typename Form>
+bool tableParse(Recognizer& steps) {
+    const Form& tables = tableForm<Form>();
+    while (true) {
+        int16_t action = tables.action(steps.top(), steps.lookahead());
+        if (isReduce(action)) {
+            int ruleIdx = reducedRule(action);
+            steps.reduce(ruleIdx);
+            steps.push(tables.gotoState(steps.top(), WLP4_PARSE_TABLES.rules[ruleIdx].lhs));
+        } else if (action == ACCEPT_ACTION) {
+            return steps.accept();
+        } else if (isShift(action)) {
+            steps.shift(action);
+        } else {
+            return steps.error();
+        }
+    }
+}
+
+template <typename Form>
+size_t formBytes() {
+    return tableForm<Form>().byteSize();
+}
+
+struct Backend {
+    const char* name;
+    bool (*parse)(Recognizer& steps);
+    size_t (*tableBytes)();
+};
+
+const Backend BACKENDS[] = {
+    {"map", tableParse<MapForm>, formBytes<MapForm>},
+    {"dense", tableParse<DenseForm>, formBytes<DenseForm>},
+    {"packed", tableParse<PackedForm>, formBytes<PackedForm>},
+#ifdef WLP4_DIRECT_PARSER
+    {"direct", directParse<Recognizer>, nullptr},
+#endif
+};
+
+// Best wall time of rounds calls of run, in seconds
+template <typename Run>
+double bestSeconds(unsigned rounds, Run run) {
+    double best = 0;
+    for (unsigned i = 0; i < rounds; ++i) {
+        auto start = chrono::steady_clock::now();
+        run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+void printTime(const char* name, size_t bytes, double seconds, size_t tokenCount, double baseSeconds) {
+    cout << setw(9) << name << ' ';
+    if (bytes) {
+        cout << setw(8) << bytes << " B ";
+    } else {
+        cout << setw(10) << "" << ' ';
+    }
+    cout << fixed << setprecision(2) << setw(9) << seconds * 1000 << " ms " << setw(8)
+         << tokenCount / seconds / 1e6 << " Mtok/s " << setw(6) << baseSeconds / seconds << "x";
+}
+
+int main(int argc, char* argv[]) {
+    unsigned rounds = 5;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        string_view arg = argv[i];
+        if (arg == "--rounds" && i + 1 < argc) {
+            rounds = max(1ul, strtoul(argv[++i], nullptr, 10));
+        } else {
+            path = argv[i];
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "ERROR: cannot open " << path << endl;
+            return 1;
+        }
+    }
+    SourceBuffer source(fd);
+    if (fd != STDIN_FILENO) close(fd);
+    string_view input = source.view();
+
+    vector<Token> tokens;
+    if (!scanTokens(input, tokens)) {
+        cerr << "ERROR" << endl;
+        return 1;
+    }
+    vector<int> symbols = {SYM_BOF};
+    for (const Token& token : tokens) symbols.push_back(token.kind);
+    symbols.push_back(SYM_EOF);
+    cout << symbols.size() << " tokens, " << WLP4_PARSE_TABLES.stateCount << " states, best of " << rounds << endl;
+
+    bool failed = false;
+    double mapSeconds = 0;
+    uint64_t expected = 0;
+    for (const Backend& backend : BACKENDS) {
+        size_t bytes = backend.tableBytes ? backend.tableBytes() : 0;
+        bool ok = false;
+        uint64_t trace = 0;
+        double seconds = bestSeconds(rounds, [&] {
+            Recognizer steps(symbols);
+            ok = backend.parse(steps);
+            trace = steps.trace;
+        });
+        if (mapSeconds == 0) {
+            mapSeconds = seconds;
+            expected = trace;
+        }
+        bool same = ok && trace == expected;
+        failed = failed || !same;
+        printTime(backend.name, bytes, seconds, symbols.size(), mapSeconds);
+        cout << (ok ? same ? "" : "  MISMATCH" : "  REJECTED") << endl;
+    }
+
+    // The whole parser: it takes its tokens once, so each round gets a new one
+    double parserSeconds = 0;
+    bool parsed = true;
+    for (unsigned i = 0; i < rounds; ++i) {
+        WLP4Parser parser;
+        for (const Token& token : tokens) parser.addToken(token.kind, token.lexeme(input));
+        auto start = chrono::steady_clock::now();
+        parsed = parser.parse() && parsed;
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < parserSeconds) parserSeconds = seconds;
+    }
+    failed = failed || !parsed;
+#if defined(WLP4_DIRECT_PARSER)
+    const char* parserTables = "direct";
+#elif defined(WLP4_PACKED_TABLES)
+    const char* parserTables = "packed";
+#else
+    const char* parserTables = "dense";
+#endif
+    printTime("parser", 0, parserSeconds, symbols.size(), mapSeconds);
+    cout << "  (" << parserTables << ")" << (parsed ? "" : "  REJECTED") << endl;
+    return failed ? 1 : 0;
+}
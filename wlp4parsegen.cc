@@ -0,0 +1,111 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "wlp4grammar.h"
+
+// Generates wlp4parsedirect.h: the LR automaton of WLP4_PARSE_TABLES as
+// direct-coded C++. Every state is a label with a switch on the lookahead
+// that shifts, reduces or fails; every nonterminal has a label that
+// switches on the exposed state to take its GOTO. The parser still keeps
+// the state stack, so the states and trees are exactly those of the
+// table-driven loop.
+//
+// Usage: wlp4parsegen > wlp4parsedirect.h
+// The generated directParse(steps) calls back into steps for the stack
+// work: lookahead(), top(), push(state), shift(state), reduce(rule),
+// accept() and error().
+
+std::string symbolConstant(int symbol) {
+  if (symbol == SYM_BOF) return "SYM_BOF";
+  if (symbol == SYM_EOF) return "SYM_EOF";
+  if (symbol == TK_NONE) return "TK_NONE";
+  return "TK_" + std::string(WLP4_PARSE_TABLES.symbolNames[symbol]);
+}
+
+void emitState(std::ostream& out, int state) {
+  const ParseTables& tables = WLP4_PARSE_TABLES;
+  out << "state" << state << ":\n";
+  out << "  switch (steps.lookahead()) {\n";
+
+  // One group of cases per distinct action, in order of first symbol
+  std::vector<int16_t> actions;
+  for (int symbol = 0; symbol <= SYM_EOF; ++symbol) {
+    int16_t action = tables.action[state][symbol];
+    if (action == 0) continue;
+    bool seen = false;
+    for (int16_t a : actions) seen = seen || a == action;
+    if (!seen) actions.push_back(action);
+  }
+  for (int16_t action : actions) {
+    for (int symbol = 0; symbol <= SYM_EOF; ++symbol) {
+      if (tables.action[state][symbol] == action) out << "    case " << symbolConstant(symbol) << ":\n";
+    }
+    if (action == ACCEPT_ACTION) {
+      out << "      return steps.accept();\n";
+    } else if (isShift(action)) {
+      out << "      steps.shift(" << action << ");\n";
+      out << "      goto state" << action << ";\n";
+    } else {
+      int rule = reducedRule(action);
+      out << "      steps.reduce(" << rule << ");  // " << tables.rules[rule].text << "\n";
+      out << "      goto after_" << tables.symbolNames[tables.rules[rule].lhs] << ";\n";
+    }
+  }
+  out << "    default:\n";
+  out << "      return steps.error();\n";
+  out << "  }\n";
+}
+
+void emitGoto(std::ostream& out, int nonterminal) {
+  const ParseTables& tables = WLP4_PARSE_TABLES;
+  out << "after_" << tables.symbolNames[nonterminal] << ":\n";
+  out << "  switch (steps.top()) {\n";
+  for (int state = 0; state < tables.stateCount; ++state) {
+    int16_t target = tables.action[state][nonterminal];
+    if (target == 0) continue;
+    out << "    case " << state << ":\n";
+    out << "      steps.push(" << target << ");\n";
+    out << "      goto state" << target << ";\n";
+  }
+  out << "    default:\n";
+  out << "      return steps.error();\n";
+  out << "  }\n";
+}
+
+int main() {
+  const ParseTables& tables = WLP4_PARSE_TABLES;
+
+  // Label only what something jumps to: every pushed state, and the
+  // nonterminals some reachable rule reduces to
+  std::vector<bool> targeted(tables.stateCount, false);
+  std::vector<bool> reduced(tables.symbolCount, false);
+  targeted[0] = true;
+  for (int state = 0; state < tables.stateCount; ++state) {
+    for (int symbol = 0; symbol < tables.symbolCount; ++symbol) {
+      int16_t action = tables.action[state][symbol];
+      if (isShift(action)) targeted[action] = true;
+      if (isReduce(action)) reduced[tables.rules[reducedRule(action)].lhs] = true;
+    }
+  }
+
+  std::ostream& out = std::cout;
+  out << "// Generated by wlp4parsegen from the WLP4 parse tables. Do not edit.\n";
+  out << "#ifndef WLP4PARSEDIRECT_H\n";
+  out << "#define WLP4PARSEDIRECT_H\n\n";
+  out << "#include \"wlp4grammar.h\"\n\n";
+  out << "// Runs the LR automaton over steps' tokens; returns what accept() or\n";
+  out << "// error() returns\n";
+  out << "template <class Steps>\n";
+  out << "bool directParse(Steps& steps) {\n";
+  out << "  goto state0;\n";
+  for (int state = 0; state < tables.stateCount; ++state) {
+    if (targeted[state]) emitState(out, state);
+  }
+  for (int symbol = FIRST_NONTERMINAL; symbol < tables.symbolCount; ++symbol) {
+    if (reduced[symbol]) emitGoto(out, symbol);
+  }
+  out << "}\n\n";
+  out << "#endif\n";
+  return 0;
+}
@@ -0,0 +1,619 @@
+#ifndef WLP4PARSER_H
+#define WLP4PARSER_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <sstream>
+#include <unordered_map>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "wlp4grammar.h"
+#include "wlp4lex.h"
+#include "wlp4tokstream.h"
+#include "wlp4ast.h"
+#include "wlp4tree.h"
+#include "wlp4treestream.h"
+
+#ifdef WLP4_DIRECT_PARSER
+// The automaton as straight-line code, generated by wlp4parsegen:
+//   g++ -std=c++17 -o wlp4parsegen wlp4parsegen.cc && ./wlp4parsegen > wlp4parsedirect.h
+#include "wlp4parsedirect.h"
+#endif
+
+// LR parser for WLP4 over the tables of wlp4grammar.h, shared by wlp4parse
+// and wlp4c. It builds the concrete parse tree in a ParseArena (or the AST
+// of wlp4ast.h) and hands it out as text, as a binary tree stream or as a
+// ParseTree.
+
+enum ParseNodeKind : uint8_t { PARSE_RULE, PARSE_TOKEN, PARSE_REUSED };
+
+// A node is a token (value = token index), a reduction (value = rule
+// index) or a subtree built ahead of the automaton (value = ready unit
+// index, see WLP4Parser::ReadyUnit). Its children are a contiguous range of
+// ParseArena::children.
+struct ParseNode {
+    uint32_t value;
+    uint32_t firstChild;
+    uint16_t childCount;
+    ParseNodeKind kind;
+};
+
+// Owns every node of one parse. Nodes are appended to one vector and
+// referred to by index, so building a tree is a bump of two vectors and
+// freeing it is reset().
+class ParseArena {
+public:
+    std::vector<ParseNode> nodes;
+    std::vector<uint32_t> children;
+
+    uint32_t addToken(uint32_t tokenIndex) {
+        nodes.push_back({tokenIndex, 0, 0, PARSE_TOKEN});
+        return nodes.size() - 1;
+    }
+
+    uint32_t addReused(uint32_t unit) {
+        nodes.push_back({unit, 0, 0, PARSE_REUSED});
+        return nodes.size() - 1;
+    }
+
+    // New node for rule whose children are the last count entries of stack
+    uint32_t addReduction(uint32_t rule, const uint32_t* stackTop, int count) {
+        nodes.push_back({rule, static_cast<uint32_t>(children.size()), static_cast<uint16_t>(count), PARSE_RULE});
+        children.insert(children.end(), stackTop - count, stackTop);
+        return nodes.size() - 1;
+    }
+
+    void reset() {
+        nodes.clear();
+        children.clear();
+    }
+};
+
+constexpr uint32_t NO_PARSE_NODE = UINT32_MAX;
+
+// The subtrees that can be built apart from the rest of the program
+constexpr int PROCEDURE_SYMBOL = grammarSymbol(WLP4_PARSE_TABLES, "procedure");
+constexpr int MAIN_SYMBOL = grammarSymbol(WLP4_PARSE_TABLES, "main");
+
+// The tree printed by an earlier run, for wlp4parse --reuse. Its procedure
+// and main subtrees are the units a new parse can take over whole.
+class PreviousTree {
+public:
+    struct Unit {
+        int symbol;           // procedure or main
+        uint32_t firstToken;  // BOF is token 0
+        uint32_t tokenCount;
+        size_t begin, end;    // its lines, as a byte range of text
+    };
+
+    std::string text;
+    std::vector<int> tokenSymbols;  // BOF and EOF included
+    std::vector<std::string_view> tokenLexemes;
+    std::vector<Unit> units;
+
+    // Reads the tree and splits it into units; false if it is not a
+    // complete parse tree
+    bool read(std::istream& in) {
+        std::ostringstream contents;
+        contents << in.rdbuf();
+        text = contents.str();
+
+        std::unordered_map<std::string_view, int> ruleIds;
+        for (int r = 0; r < WLP4_PARSE_TABLES.ruleCount; ++r) {
+            ruleIds.emplace(WLP4_PARSE_TABLES.rules[r].text, r);
+        }
+
+        // The nodes still missing children, outermost first
+        struct Open {
+            int remaining;
+            int symbol;
+            uint32_t firstToken;
+            size_t begin;
+        };
+        std::vector<Open> open;
+        bool complete = false;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            if (complete) return false;
+            size_t end = text.find('\n', pos);
+            if (end == std::string::npos) end = text.size();
+            std::string_view line(text.data() + pos, end - pos);
+            size_t begin = pos;
+            pos = std::min(end + 1, text.size());
+
+            int symbol = terminalSymbol(line.substr(0, line.find(' ')));
+            if (symbol == TK_NONE) {
+                auto rule = ruleIds.find(line);
+                if (rule == ruleIds.end()) return false;
+                const Production& production = WLP4_PARSE_TABLES.rules[rule->second];
+                if (production.length > 0) {
+                    open.push_back({production.length, production.lhs, static_cast<uint32_t>(tokenSymbols.size()), begin});
+                    continue;
+                }
+            } else {
+                size_t space = line.find(' ');
+                tokenSymbols.push_back(symbol);
+                tokenLexemes.push_back(space == std::string_view::npos ? std::string_view() : line.substr(space + 1));
+            }
+
+            // A node is complete; so is every parent it was the last child of
+            while (!open.empty() && --open.back().remaining == 0) {
+                const Open& node = open.back();
+                if (node.symbol == PROCEDURE_SYMBOL || node.symbol == MAIN_SYMBOL) {
+                    units.push_back({node.symbol, node.firstToken,
+                                     static_cast<uint32_t>(tokenSymbols.size() - node.firstToken), node.begin, pos});
+                }
+                open.pop_back();
+            }
+            complete = open.empty();
+        }
+        return complete;
+    }
+};
+
+class WLP4Parser {
+private:
+    std::vector<int> tokenSymbols;  // grammar symbol IDs, BOF and EOF included
+    SymbolTable lexemes;
+    std::vector<uint32_t> tokenLexemes;  // IDs in lexemes
+    int tokenIndex;
+    bool binaryInput;  // read the wlp4scan --binary token stream instead of text
+    bool astOutput;    // build and print the abstract syntax tree instead
+    bool binaryTreeOutput;  // write the parse tree as a binary tree stream
+    ParseArena arena;
+    AstTree ast;
+    uint32_t treeRoot = NO_PARSE_NODE;  // of the tree the last parse() accepted
+
+    // The stream's symbols are interned straight into lexemes, so the
+    // records' IDs are the parser's
+    bool readBinaryInput(std::istream& in) {
+        std::vector<TokenRecord> records;
+        if (!readTokenStream(in, records, lexemes)) return false;
+        tokenSymbols.reserve(tokenSymbols.size() + records.size() + 1);
+        tokenLexemes.reserve(tokenLexemes.size() + records.size() + 1);
+        for (const TokenRecord& record : records) {
+            tokenSymbols.push_back(record.kind);
+            tokenLexemes.push_back(record.symbol);
+        }
+        return true;
+    }
+
+    void readInput(std::istream& in) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty()) continue;
+            std::istringstream iss(line);
+            std::string kind, lexeme;
+            iss >> kind;
+            std::getline(iss, lexeme);
+            if (!lexeme.empty() && lexeme[0] == ' ') {
+                lexeme = lexeme.substr(1);
+            }
+            tokenSymbols.push_back(terminalSymbol(kind));
+            tokenLexemes.push_back(lexemes.intern(lexeme));
+        }
+    }
+
+    // "KIND lexeme" for a token, the production text for a reduction
+    void printNode(std::ostream& out, const ParseNode& node) const {
+        if (node.kind == PARSE_RULE) {
+            out << WLP4_PARSE_TABLES.rules[node.value].text;
+            return;
+        }
+        int symbol = tokenSymbols[node.value];
+        std::string_view kind = WLP4_PARSE_TABLES.symbolNames[symbol];
+        out << kind << ' ';
+        if (symbol == SYM_BOF || symbol == SYM_EOF) {
+            out << kind;
+        } else {
+            out << lexemes.name(tokenLexemes[node.value]);
+        }
+    }
+
+    // The node as a record of a binary tree stream
+    void addNode(TreeStreamWriter& writer, const ParseNode& node) const {
+        if (node.kind == PARSE_RULE) {
+            writer.addRule(node.value);
+        } else {
+            writer.addToken(tokenSymbols[node.value], lexemes.name(tokenLexemes[node.value]));
+        }
+    }
+
+    // Preorder with an explicit stack: the statement and procedure lists
+    // make the tree as deep as the program is long. With binaryTreeOutput
+    // the nodes go to one binary tree stream instead of lines.
+    void printParseTree(std::ostream& out, const ParseArena& from, uint32_t rootIdx) const {
+        TreeStreamWriter writer;
+        std::vector<std::pair<const ParseArena*, uint32_t>> pending = {{&from, rootIdx}};
+        while (!pending.empty()) {
+            auto [nodes, nodeIdx] = pending.back();
+            pending.pop_back();
+            const ParseNode& node = nodes->nodes[nodeIdx];
+            if (node.kind == PARSE_REUSED) {
+                const ReadyUnit& unit = readyUnits[node.value];
+                if (unit.arena) {
+                    pending.push_back({unit.arena, unit.root});
+                } else {
+                    const PreviousTree::Unit& old = previous->units[unit.root];
+                    out.write(previous->text.data() + old.begin, old.end - old.begin);
+                }
+                continue;
+            }
+            if (binaryTreeOutput) {
+                addNode(writer, node);
+            } else {
+                printNode(out, node);
+                out << '\n';
+            }
+            for (uint32_t i = node.childCount; i-- > 0;) {
+                pending.push_back({nodes, nodes->children[node.firstChild + i]});
+            }
+        }
+        if (binaryTreeOutput) writer.write(out);
+    }
+
+    // LR steps, shared by the table loop and the direct-coded automaton
+    // (see wlp4parsegen.cc)
+    std::vector<uint32_t> nodeStack;
+    std::vector<int> stateStack;
+    int tokenCount = 0;
+    int shifted = 0;
+
+    // Subtrees built ahead of the automaton, taken over from the previous
+    // tree (--reuse) or parsed on worker threads (--jobs). readyAt[i] is the
+    // unit that can stand for the tokens starting at i, or -1.
+    struct ReadyUnit {
+        int symbol;  // procedure or main
+        uint32_t tokenCount;
+        const ParseArena* arena;  // holding the subtree, null for the previous tree
+        uint32_t root;            // in arena, or the unit of the previous tree
+    };
+    std::vector<ReadyUnit> readyUnits;
+    std::vector<int> readyAt;
+    std::vector<ParseArena> unitArenas;  // one per worker thread
+    const PreviousTree* previous = nullptr;
+    const TokenChange* previousChange = nullptr;  // the edit since previous, if known
+    int jobs = 1;
+
+    void addReadyUnit(int firstToken, const ReadyUnit& unit) {
+        readyAt[firstToken] = readyUnits.size();
+        readyUnits.push_back(unit);
+    }
+
+    // The edit is the token range relexEdit reported, or else whatever
+    // lies between the longest common prefix and suffix of the old and new
+    // tokens; units entirely outside it keep their tokens, shifted by the
+    // change in length in the suffix
+    void planReuse() {
+        const std::vector<int>& oldSymbols = previous->tokenSymbols;
+        const std::vector<std::string_view>& oldLexemes = previous->tokenLexemes;
+        int oldCount = oldSymbols.size();
+        int prefix = 0;
+        int suffix = 0;
+        // The change counts tokens without BOF and EOF
+        if (previousChange && previousChange->oldEnd + 2 <= static_cast<size_t>(oldCount) &&
+            oldCount - previousChange->oldEnd == tokenCount - previousChange->newEnd) {
+            prefix = previousChange->first + 1;
+            suffix = oldCount - 1 - previousChange->oldEnd;
+        } else {
+            auto same = [&](int oldIdx, int newIdx) {
+                return oldSymbols[oldIdx] == tokenSymbols[newIdx] && oldLexemes[oldIdx] == lexemes.name(tokenLexemes[newIdx]);
+            };
+            while (prefix < oldCount && prefix < tokenCount && same(prefix, prefix)) prefix++;
+            while (suffix < oldCount - prefix && suffix < tokenCount - prefix &&
+                   same(oldCount - 1 - suffix, tokenCount - 1 - suffix)) {
+                suffix++;
+            }
+        }
+        for (size_t i = 0; i < previous->units.size(); ++i) {
+            const PreviousTree::Unit& unit = previous->units[i];
+            int first = unit.firstToken;
+            if (first + static_cast<int>(unit.tokenCount) <= prefix) {
+                addReadyUnit(first, {unit.symbol, unit.tokenCount, nullptr, static_cast<uint32_t>(i)});
+            } else if (first >= oldCount - suffix) {
+                addReadyUnit(first + tokenCount - oldCount, {unit.symbol, unit.tokenCount, nullptr, static_cast<uint32_t>(i)});
+            }
+        }
+    }
+
+    // Runs the automaton from the state after BOF over the tokens from first
+    // until they reduce to a procedure or main, building into unitArena;
+    // returns the node, or NO_PARSE_NODE on a syntax error. Only reads the
+    // parser, so workers can run it side by side.
+    uint32_t parseUnit(int first, ParseArena& unitArena, std::vector<uint32_t>& nodes, std::vector<int>& states) const {
+        nodes.clear();
+        states.assign({0, parseAction(0, SYM_BOF)});
+        int index = first;
+        while (true) {
+            int16_t action = parseAction(states.back(), tokenSymbols[index]);
+            if (isReduce(action)) {
+                int ruleIdx = reducedRule(action);
+                const Production& rule = WLP4_PARSE_TABLES.rules[ruleIdx];
+                uint32_t node = unitArena.addReduction(ruleIdx, nodes.data() + nodes.size(), rule.length);
+                nodes.resize(nodes.size() - rule.length);
+                states.resize(states.size() - rule.length);
+                if (states.size() == 2) {
+                    return rule.lhs == PROCEDURE_SYMBOL || rule.lhs == MAIN_SYMBOL ? node : NO_PARSE_NODE;
+                }
+                nodes.push_back(node);
+                states.push_back(gotoState(states.back(), rule.lhs));
+            } else if (isShift(action)) {
+                nodes.push_back(unitArena.addToken(index++));
+                states.push_back(action);
+            } else {
+                return NO_PARSE_NODE;
+            }
+        }
+    }
+
+    // Splits the tokens at the top-level closing braces, parses the pieces
+    // on jobs threads and makes the ones that parse ready units. Splitting
+    // stops at anything that does not look like INT ... RBRACE; the
+    // automaton parses the rest itself.
+    void parseUnitsInParallel() {
+        std::vector<std::pair<int, int>> pieces;  // [first, end) token ranges
+        int depth = 0;
+        int first = 1;
+        for (int i = 1; i < tokenCount - 1; ++i) {
+            int symbol = tokenSymbols[i];
+            if (i == first && symbol != TK_INT) break;
+            if (symbol == TK_LBRACE) {
+                depth++;
+            } else if (symbol == TK_RBRACE) {
+                if (--depth < 0) break;
+                if (depth == 0) {
+                    if (readyAt[first] < 0) pieces.push_back({first, i + 1});
+                    first = i + 1;
+                }
+            }
+        }
+        if (pieces.size() < 2) return;
+
+        // Contiguous runs of pieces with about the same number of tokens each
+        int workers = std::min<size_t>(jobs, pieces.size());
+        long total = 0;
+        for (auto [begin, end] : pieces) total += end - begin;
+        std::vector<size_t> runStart(workers + 1, pieces.size());
+        runStart[0] = 0;
+        long seen = 0;
+        for (size_t p = 0, w = 1; p < pieces.size() && w < static_cast<size_t>(workers); ++p) {
+            seen += pieces[p].second - pieces[p].first;
+            if (seen * workers >= total * static_cast<long>(w)) runStart[w++] = p + 1;
+        }
+
+        unitArenas.assign(workers, ParseArena());
+        std::vector<uint32_t> roots(pieces.size(), NO_PARSE_NODE);
+        auto work = [&](int w) {
+            std::vector<uint32_t> nodes;
+            std::vector<int> states;
+            for (size_t p = runStart[w]; p < runStart[w + 1]; ++p) {
+                roots[p] = parseUnit(pieces[p].first, unitArenas[w], nodes, states);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int w = 1; w < workers; ++w) threads.emplace_back(work, w);
+        work(0);
+        for (std::thread& t : threads) t.join();
+
+        for (int w = 0; w < workers; ++w) {
+            for (size_t p = runStart[w]; p < runStart[w + 1]; ++p) {
+                if (roots[p] == NO_PARSE_NODE) continue;
+                int symbol = WLP4_PARSE_TABLES.rules[unitArenas[w].nodes[roots[p]].value].lhs;
+                addReadyUnit(pieces[p].first, {symbol, static_cast<uint32_t>(pieces[p].second - pieces[p].first),
+                                               &unitArenas[w], roots[p]});
+            }
+        }
+    }
+
+    // Takes over a ready unit when the parser is in a state that expects its
+    // nonterminal. The grammar is unambiguous and a unit is a complete
+    // procedure or main parsed with its real lookahead, so this is the
+    // subtree a full parse would build. Pieces that failed to parse are not
+    // ready, so syntax errors are still found and reported by the automaton.
+    bool takeReadyUnit() {
+        int ready = readyAt[tokenIndex];
+        if (ready < 0) return false;
+        const ReadyUnit& unit = readyUnits[ready];
+        int target = gotoState(top(), unit.symbol);
+        if (target == 0) return false;
+        nodeStack.push_back(arena.addReused(ready));
+        push(target);
+        tokenIndex += unit.tokenCount;
+        shifted += unit.tokenCount;
+        return true;
+    }
+
+    int lookahead() const {
+        return (tokenIndex < tokenCount) ? tokenSymbols[tokenIndex] : TK_NONE;
+    }
+
+    int top() const {
+        return stateStack.back();
+    }
+
+    void push(int state) {
+        stateStack.push_back(state);
+    }
+
+    // push the next token and its state
+    void shift(int state) {
+        int symbol = tokenSymbols[tokenIndex];
+        if (astOutput) {
+            bool kept = symbol == TK_ID || symbol == TK_NUM;
+            nodeStack.push_back(kept ? ast.addToken(symbol, tokenLexemes[tokenIndex]) : NO_AST_NODE);
+        } else {
+            nodeStack.push_back(arena.addToken(tokenIndex));
+        }
+        stateStack.push_back(state);
+        tokenIndex++;
+        if (symbol != SYM_BOF && symbol != SYM_EOF) {
+            shifted++;
+        }
+    }
+
+    // create the node for this rule from the top of the node stack, and pop
+    // the symbols and states it covers; the caller pushes the GOTO state
+    void reduce(int ruleIdx) {
+        const Production& rule = WLP4_PARSE_TABLES.rules[ruleIdx];
+        uint32_t* stackTop = nodeStack.data() + nodeStack.size();
+        uint32_t newNode = astOutput ? ast.reduce(ruleIdx, stackTop - rule.length)
+                                     : arena.addReduction(ruleIdx, stackTop, rule.length);
+        nodeStack.resize(nodeStack.size() - rule.length);
+        stateStack.resize(stateStack.size() - rule.length);
+        nodeStack.push_back(newNode);
+    }
+
+    // Shifting into the accepting state: push the token (its state is never
+    // looked at) and make the final reduction
+    bool accept() {
+        shift(top());
+        reduce(WLP4_PARSE_TABLES.acceptRule);
+        treeRoot = nodeStack.back();
+        return true;
+    }
+
+    bool error() {
+        std::cerr << "ERROR at " << (shifted + 1) << std::endl;
+        return false;
+    }
+
+#ifdef WLP4_DIRECT_PARSER
+    template <class Steps>
+    friend bool directParse(Steps& steps);
+#endif
+
+public:
+    WLP4Parser(bool binaryInput = false, bool astOutput = false, bool binaryTreeOutput = false)
+        : tokenSymbols{SYM_BOF}, tokenLexemes{lexemes.intern("BOF")}, tokenIndex(0), binaryInput(binaryInput),
+          astOutput(astOutput), binaryTreeOutput(binaryTreeOutput) {}
+
+    // Appends a token to the input
+    void addToken(int symbol, std::string_view lexeme) {
+        tokenSymbols.push_back(symbol);
+        tokenLexemes.push_back(lexemes.intern(lexeme));
+    }
+
+    // Appends the tokens wlp4scan writes to in: its text lines, or its
+    // binary token stream if the parser takes binary input. False if the
+    // binary stream is malformed.
+    bool readTokens(std::istream& in) {
+        if (binaryInput) return readBinaryInput(in);
+        readInput(in);
+        return true;
+    }
+
+    // Parse incrementally against tree, which must outlive the parser.
+    // Only the concrete text tree output can reuse subtrees.
+    void reuseFrom(const PreviousTree& tree) {
+        previous = &tree;
+        previousChange = nullptr;
+    }
+
+    // The same, when relexEdit has said which tokens an edit changed: tree
+    // must be the parse of the tokens before that edit, and the ones outside
+    // change are taken as they are instead of being compared again. change
+    // must outlive the parser too.
+    void reuseFrom(const PreviousTree& tree, const TokenChange& change) {
+        previous = &tree;
+        previousChange = &change;
+    }
+
+    // Parse the procedures on up to count threads; concrete tree output only
+    void useThreads(int count) {
+        jobs = count;
+    }
+
+    // Parses the input; false on a syntax error, which goes to std::cerr.
+    // Call once, after all the tokens are in.
+    bool parse() {
+        tokenSymbols.push_back(SYM_EOF);
+        tokenLexemes.push_back(lexemes.intern("EOF"));
+
+        arena.reset();
+        ast.reset();
+        arena.nodes.reserve(2 * tokenSymbols.size());
+        arena.children.reserve(2 * tokenSymbols.size());
+        nodeStack.clear();
+        stateStack.assign(1, 0);
+
+        tokenIndex = 0;
+        shifted = 0;
+        tokenCount = tokenSymbols.size();
+
+        readyUnits.clear();
+        readyAt.assign(tokenCount, -1);
+        if (previous && !astOutput && !binaryTreeOutput) {
+            planReuse();
+        } else {
+            previous = nullptr;
+        }
+        if (jobs > 1 && !astOutput) {
+            parseUnitsInParallel();
+        }
+
+#ifdef WLP4_DIRECT_PARSER
+        // The generated code has no hook for taking over subtrees
+        if (readyUnits.empty()) return directParse(*this);
+#endif
+        while (true) {
+            if (!readyUnits.empty() && takeReadyUnit()) continue;
+            int16_t action = parseAction(top(), lookahead());
+            if (isReduce(action)) {
+                int ruleIdx = reducedRule(action);
+                reduce(ruleIdx);
+                push(gotoState(top(), WLP4_PARSE_TABLES.rules[ruleIdx].lhs));
+            } else if (action == ACCEPT_ACTION) {
+                return accept();
+            } else if (isShift(action)) {
+                shift(action);
+            } else {
+                return error();
+            }
+        }
+    }
+
+    // Writes the tree parse() accepted: its text lines, its binary tree
+    // stream or its AST, as the parser was made to output
+    void write(std::ostream& out) const {
+        if (astOutput) {
+            writeAst(out, ast, treeRoot, lexemes);
+        } else {
+            printParseTree(out, arena, treeRoot);
+        }
+    }
+
+    // Builds the concrete tree parse() accepted into tree and returns its
+    // root. The parser must output the concrete tree and not reuse one. Its
+    // lexemes move to the tree with their IDs, so it cannot write after.
+    TreeNode* buildTree(ParseTree& tree) {
+        tree.lexemes = std::move(lexemes);
+        std::vector<std::pair<const ParseArena*, uint32_t>> pending = {{&arena, treeRoot}};
+        return tree.build([&](TreeNode& node) {
+            if (pending.empty()) return -1;
+            auto [nodes, nodeIdx] = pending.back();
+            pending.pop_back();
+            const ParseNode* parsed = &nodes->nodes[nodeIdx];
+            while (parsed->kind == PARSE_REUSED) {
+                const ReadyUnit& unit = readyUnits[parsed->value];
+                nodes = unit.arena;
+                parsed = &nodes->nodes[unit.root];
+            }
+            if (parsed->kind == PARSE_RULE) {
+                node.rule = WLP4_PARSE_TABLES.rules[parsed->value].text;
+            } else {
+                node.tokenKind = WLP4_PARSE_TABLES.symbolNames[tokenSymbols[parsed->value]];
+                tree.setLexeme(node, tokenLexemes[parsed->value]);
+            }
+            for (uint32_t i = parsed->childCount; i-- > 0;) {
+                pending.push_back({nodes, nodes->children[parsed->firstChild + i]});
+            }
+            return static_cast<int>(parsed->childCount);
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,410 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <pthread.h>
+#include "wlp4lex.h"
+#include "wlp4parser.h"
+#include "wlp4ast.h"
+#include "wlp4typechecker.h"
+#include "wlp4codegen.h"
+
+using namespace std;
+
+// Usage: wlp4scaletest [--max n] [--shape name]... [--light]
+// Generates programs that grow one way at a time (more statements, more
+// procedures, longer + and * chains, deeper parentheses, ifs and whiles,
+// more declarations, longer argument lists) at sizes 1000, 10000, ... up
+// to --max (100000 by default; 1000000 statements or nested ifs take over
+// 5 GB). Each one goes through every path the tools offer on an 8 MB
+// stack, the usual limit for a main thread:
+//   text   scan, parse, print the tree, read it back, check, print the
+//          typed tree, read it back and generate, as the tools do in turn
+//   direct the tree wlp4c builds in process, checked and generated
+//   binary the typed tree through the binary tree stream, then generated
+//   ast    the parser's AST printed, read back, expanded and checked,
+//          then its typed AST printed, read back and generated
+// The typed trees and the assembly have to match the text path's. The
+// tree text, the binary tree and the AST are also read cut short, which
+// has to fail rather than leave a node without its children. Prints a
+// line per shape and size and exits with 1 if any of them fails; a
+// walker that still recurses shows up as a crash.
+//
+// --light runs the statements shape alone up to 10000000 statements (or
+// --max) through the paths that hold no TreeNode tree, which at that size
+// would not fit in memory:
+//   text   scan, parse and print the tree, which has to grow by the same
+//          lines for every two statements
+//   ast    the parser's AST printed, read back and printed the same again
+// 10000000 statements take under 4 GB there.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o wlp4scaletest wlp4scaletest.cc
+
+constexpr size_t TEST_STACK_SIZE = 8 << 20;
+
+struct Shape {
+    const char* name;
+    string (*generate)(size_t n);
+};
+
+string statementsProgram(size_t n) {
+    string program = "int wain(int a, int b) {\n";
+    for (size_t i = 0; i < n; ++i) {
+        program += i % 2 ? "println(a);\n" : "a = a + " + to_string(i % 7) + ";\n";
+    }
+    return program + "return a;\n}\n";
+}
+
+string proceduresProgram(size_t n) {
+    string program;
+    for (size_t i = 0; i < n; ++i) {
+        program += "int p" + to_string(i) + "(int x) { return x + 1; }\n";
+    }
+    return program + "int wain(int a, int b) { return p" + to_string(n - 1) + "(a); }\n";
+}
+
+string chainProgram(size_t n, const char* op) {
+    string program = "int wain(int a, int b) { return a";
+    for (size_t i = 0; i < n; ++i) {
+        program += op;
+        program += '1';
+    }
+    return program + "; }\n";
+}
+
+string plusProgram(size_t n) {
+    return chainProgram(n, " + ");
+}
+
+string starProgram(size_t n) {
+    return chainProgram(n, " * ");
+}
+
+string parensProgram(size_t n) {
+    return "int wain(int a, int b) { return " + string(n, '(') + "a" + string(n, ')') + "; }\n";
+}
+
+string ifsProgram(size_t n) {
+    string program = "int wain(int a, int b) {\n";
+    for (size_t i = 0; i < n; ++i) program += "if (a < b) {\n";
+    program += "a = a + 1;\n";
+    for (size_t i = 0; i < n; ++i) program += "} else { println(a); }\n";
+    return program + "return a;\n}\n";
+}
+
+string whilesProgram(size_t n) {
+    string program = "int wain(int a, int b) {\n";
+    for (size_t i = 0; i < n; ++i) program += "while (a < b) {\n";
+    program += "a = a + 1;\n";
+    for (size_t i = 0; i < n; ++i) program += "}\n";
+    return program + "return a;\n}\n";
+}
+
+string dclsProgram(size_t n) {
+    string program = "int wain(int a, int b) {\n";
+    for (size_t i = 0; i < n; ++i) {
+        program += i % 2 ? "int* q" + to_string(i) + " = NULL;\n" : "int v" + to_string(i) + " = " + to_string(i % 100) + ";\n";
+    }
+    return program + "return a;\n}\n";
+}
+
+string argsProgram(size_t n) {
+    string params, args;
+    for (size_t i = 0; i < n; ++i) {
+        params += (i ? ", int x" : "int x") + to_string(i);
+        args += i ? ", a" : "a";
+    }
+    return "int f(" + params + ") { return x0; }\nint wain(int a, int b) { return f(" + args + "); }\n";
+}
+
+const Shape SHAPES[] = {
+    {"statements", statementsProgram},
+    {"procedures", proceduresProgram},
+    {"plus", plusProgram},
+    {"star", starProgram},
+    {"parens", parensProgram},
+    {"ifs", ifsProgram},
+    {"whiles", whilesProgram},
+    {"dcls", dclsProgram},
+    {"args", argsProgram},
+};
+
+// Feeds the tokens of program to parser; false if it does not scan
+bool addTokens(const string& program, WLP4Parser& parser) {
+    vector<Token> tokens;
+    if (!scanTokens(program, tokens)) return false;
+    for (const Token& token : tokens) parser.addToken(token.kind, token.lexeme(program));
+    return true;
+}
+
+// Reads the tree in text, or only its first lineCount lines
+TreeNode* readTreeText(ParseTree& tree, const string& text, size_t lineCount = SIZE_MAX) {
+    istringstream in(text);
+    return tree.read([&](string& line) { return lineCount-- > 0 && getline(in, line); });
+}
+
+size_t countLines(const string& text) {
+    return count(text.begin(), text.end(), '\n');
+}
+
+string typedText(TreeNode* root) {
+    ostringstream out;
+    writeTree(out, root);
+    return out.str();
+}
+
+string assembly(const ParseTree& tree, TreeNode* root) {
+    ostringstream out;
+    CodeGenerator generator(out);
+    generator.generate(root, tree.lexemes.size());
+    return out.str();
+}
+
+// Runs program through every path; the first one that fails, or "" if
+// none does
+string runPaths(const string& program) {
+    // text: what wlp4scan | wlp4parse | wlp4type | wlp4gen does
+    string treeText;
+    {
+        WLP4Parser parser;
+        if (!addTokens(program, parser)) return "text: scan";
+        if (!parser.parse()) return "text: parse";
+        ostringstream out;
+        parser.write(out);
+        treeText = out.str();
+    }
+    string typed, expected;
+    {
+        ParseTree tree;
+        TreeNode* root = readTreeText(tree, treeText);
+        TypeChecker checker;
+        if (!root || !checker.check(root, tree.lexemes.size())) return "text: type";
+        typed = typedText(root);
+    }
+    size_t lineCount = countLines(treeText);
+    for (size_t cut : {lineCount - 1, lineCount / 2, size_t(1)}) {
+        ParseTree tree;
+        if (readTreeText(tree, treeText, cut)) return "text: read cut short";
+    }
+    {
+        ParseTree tree;
+        TreeNode* root = readTreeText(tree, typed);
+        if (!root) return "text: gen";
+        expected = assembly(tree, root);
+    }
+    treeText.clear();
+    treeText.shrink_to_fit();
+
+    // direct and binary: the tree built in process, as wlp4c uses it
+    {
+        WLP4Parser parser;
+        ParseTree tree;
+        addTokens(program, parser);
+        if (!parser.parse()) return "direct: parse";
+        TreeNode* root = parser.buildTree(tree);
+        TypeChecker checker;
+        if (!checker.check(root, tree.lexemes.size()) || typedText(root) != typed) return "direct: type";
+
+        ostringstream out;
+        if (!writeTreeStream(out, root)) return "binary: write";
+        string data = out.str();
+        TreeStreamView stream;
+        ParseTree binaryTree;
+        if (!stream.open(data)) return "binary: read";
+        if (TreeStreamView().open(string_view(data).substr(0, data.size() / 2))) return "binary: read cut short";
+        TreeNode* binaryRoot = binaryTree.read(stream);
+        if (!binaryRoot || assembly(binaryTree, binaryRoot) != expected) return "binary: gen";
+
+        walkPreorder(root, [](TreeNode* node, TreeNode*) {
+            if (!showsType(node)) node->type.clear();
+            return true;
+        });
+        if (assembly(tree, root) != expected) return "direct: gen";
+    }
+
+    // ast: wlp4parse --ast | wlp4type --ast
+    {
+        WLP4Parser parser(false, true);
+        addTokens(program, parser);
+        if (!parser.parse()) return "ast: parse";
+        ostringstream out;
+        parser.write(out);
+        string astText = out.str();
+        {
+            string_view text = astText;
+            istringstream in(string(text.substr(0, text.rfind('\n', text.length() / 2) + 1)));
+            AstTree ast;
+            ParseTree tree;
+            uint32_t astRoot = 0;
+            if (readAst(in, ast, tree.lexemes, astRoot) && expandAst(ast, astRoot, tree)) return "ast: read cut short";
+        }
+        istringstream in(astText);
+        astText.clear();
+        astText.shrink_to_fit();
+        AstTree ast;
+        ParseTree tree;
+        uint32_t astRoot = 0;
+        if (!readAst(in, ast, tree.lexemes, astRoot)) return "ast: read";
+        vector<TreeNode*> made;
+        TreeNode* root = expandAst(ast, astRoot, tree, &made);
+        TypeChecker checker;
+        if (!root || !checker.check(root, tree.lexemes.size()) || typedText(root) != typed) return "ast: type";
+
+        // wlp4type --ast | wlp4gen --ast
+        takeAstTypes(ast, made);
+        ostringstream typedOut;
+        writeAst(typedOut, ast, astRoot, tree.lexemes);
+        istringstream typedIn(typedOut.str());
+        AstTree typedAst;
+        ParseTree typedTree;
+        if (!readAst(typedIn, typedAst, typedTree.lexemes, astRoot)) return "ast: read typed";
+        root = expandAst(typedAst, astRoot, typedTree);
+        if (!root || typedText(root) != typed) return "ast: expand typed";
+        if (assembly(typedTree, root) != expected) return "ast: gen";
+    }
+    return "";
+}
+
+// Counts and hashes what is written to it without keeping it, for trees
+// too large to hold as text
+class DigestBuffer : public streambuf {
+public:
+    size_t lines = 0;
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a
+
+protected:
+    int overflow(int c) override {
+        if (c != EOF) add(static_cast<char>(c));
+        return 0;
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        for (streamsize i = 0; i < n; ++i) add(s[i]);
+        return n;
+    }
+
+private:
+    void add(char c) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        lines += c == '\n';
+    }
+};
+
+// Lines of the tree the parser prints for program; 0 if it does not parse
+size_t treeLineCount(const string& program) {
+    WLP4Parser parser;
+    if (!addTokens(program, parser) || !parser.parse()) return 0;
+    DigestBuffer digest;
+    ostream out(&digest);
+    parser.write(out);
+    return digest.lines;
+}
+
+// Runs the statements program of size n through the paths of --light;
+// the first one that fails, or "" if none does
+string runLightPaths(size_t n) {
+    // A statement pair adds as many lines as the first pair does
+    size_t empty = treeLineCount(statementsProgram(0));
+    size_t expectedLines = empty + n / 2 * (treeLineCount(statementsProgram(2)) - empty);
+    string program = statementsProgram(n);
+    if (treeLineCount(program) != expectedLines) return "text: parse and print";
+
+    WLP4Parser parser(false, true);
+    addTokens(program, parser);
+    program.clear();
+    program.shrink_to_fit();
+    if (!parser.parse()) return "ast: parse";
+    ostringstream out;
+    parser.write(out);
+    string astText = out.str();
+    DigestBuffer printed;
+    printed.sputn(astText.data(), astText.size());
+    istringstream in(astText);
+    astText.clear();
+    astText.shrink_to_fit();
+    AstTree ast;
+    SymbolTable lexemes;
+    uint32_t astRoot = 0;
+    if (!readAst(in, ast, lexemes, astRoot)) return "ast: read";
+    DigestBuffer digest;
+    ostream again(&digest);
+    writeAst(again, ast, astRoot, lexemes);
+    if (digest.hash != printed.hash || digest.lines != printed.lines) return "ast: write";
+    return "";
+}
+
+struct TestRun {
+    size_t maxSize = 100000;
+    vector<string_view> shapes;
+    bool light = false;
+    bool failed = false;
+};
+
+void report(const char* name, size_t n, chrono::steady_clock::time_point start, const string& failure) {
+    auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    cout << name << ' ' << n << ' ' << ms << "ms " << (failure.empty() ? "ok" : "FAILED " + failure) << endl;
+}
+
+void* runTests(void* arg) {
+    TestRun& run = *static_cast<TestRun*>(arg);
+    if (run.light) {
+        for (size_t n = 1000; n <= run.maxSize; n *= 10) {
+            auto start = chrono::steady_clock::now();
+            string failure = runLightPaths(n);
+            report("statements-light", n, start, failure);
+            run.failed = run.failed || !failure.empty();
+        }
+        return nullptr;
+    }
+    for (const Shape& shape : SHAPES) {
+        bool selected = run.shapes.empty();
+        for (string_view name : run.shapes) selected = selected || name == shape.name;
+        if (!selected) continue;
+        for (size_t n = 1000; n <= run.maxSize; n *= 10) {
+            auto start = chrono::steady_clock::now();
+            string failure = runPaths(shape.generate(n));
+            report(shape.name, n, start, failure);
+            run.failed = run.failed || !failure.empty();
+        }
+    }
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    TestRun run;
+    const char* maxSize = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        string_view arg = argv[i];
+        if (arg == "--max" && i + 1 < argc) {
+            maxSize = argv[++i];
+        } else if (arg == "--shape" && i + 1 < argc) {
+            run.shapes.push_back(argv[++i]);
+        } else if (arg == "--light") {
+            run.light = true;
+        } else {
+            cerr << "ERROR: unknown option " << arg << endl;
+            return 1;
+        }
+    }
+    if (run.light) run.maxSize = 10000000;
+    if (maxSize) run.maxSize = strtoull(maxSize, nullptr, 10);
+
+    // The tests run on a thread with a stack of the usual size, whatever
+    // the limit of this process's own stack is
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, TEST_STACK_SIZE);
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, runTests, &run) != 0) {
+        cerr << "ERROR: cannot start the test thread" << endl;
+        return 1;
+    }
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+    return run.failed ? 1 : 0;
+}
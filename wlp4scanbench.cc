@@ -0,0 +1,206 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "wlp4input.h"
+#include "wlp4lex.h"
+
+using namespace std;
+
+// Usage: wlp4scanbench [--threads n] [--rounds r] [file]   (reads stdin when no file is given)
+// First times the scanner cores on one thread, each through scanRange:
+//   map     the DFA read from its text at run time into maps keyed by
+//           state name, one lookup per byte, as wlp4scan first did
+//   table   the dense WLP4_DFA table
+//   direct  the code wlp4lexgen generates, in builds with -DWLP4_DIRECT_LEXER
+// Then times scanTokensParallel on the input with 1, 2, 4, ... threads up to n
+// (every hardware thread by default), best of r rounds (5 by default), and
+// prints the throughput and the speedup over one thread. Every run's tokens
+// have to match the sequential scan's. Inputs are only split into chunks of
+// at least MIN_PARALLEL_CHUNK bytes, so the input needs to be a few of those
+// per thread for the larger counts to mean anything.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o wlp4scanbench wlp4scanbench.cc
+// With the direct core (wlp4lexgen > wlp4lexdirect.h first, see wlp4lex.h):
+//   g++ -std=c++17 -O2 -pthread -DWLP4_DIRECT_LEXER -o wlp4scanbench wlp4scanbench.cc
+
+// The DFA as the original scanner held it: transitions by state name and
+// character, read from wlp4_dfa_string when first used
+struct MapDFA {
+    unordered_map<string, unordered_map<char, string>> transitions;
+    unordered_map<string, TokenKind> accept;  // the token kind of each accepting state
+    string start;
+};
+
+const MapDFA& mapDFA() {
+    static const MapDFA dfa = [] {
+        MapDFA dfa;
+        SpecReader in{wlp4_dfa_string};
+        string_view line, word;
+        while (in.nextLine(line) && line != STATES) {}
+        while (in.nextLine(line) && line != TRANSITIONS) {
+            while (nextWord(line, word)) {
+                bool accepting = word.back() == '!' && !isChar(word);
+                if (accepting) word.remove_suffix(1);
+                if (dfa.start.empty()) dfa.start = string(word);
+                if (accepting) dfa.accept[string(word)] = stateKind(word);
+            }
+        }
+        while (in.nextLine(line) && line != INPUT) {
+            vector<string_view> words;
+            while (nextWord(line, word)) words.push_back(word);
+            if (words.size() < 3) continue;
+            auto& row = dfa.transitions[string(words[0])];
+            for (size_t i = 1; i + 1 < words.size(); ++i) {
+                string_view s = words[i];
+                if (isChar(s)) {
+                    row[s[0]] = string(words.back());
+                } else if (isRange(s)) {
+                    for (int c = s[0]; c <= s[2]; ++c) row[static_cast<char>(c)] = string(words.back());
+                }
+            }
+        }
+        return dfa;
+    }();
+    return dfa;
+}
+
+struct MapMatcher {
+    const MapDFA& dfa = mapDFA();
+
+    size_t munch(const unsigned char* s, size_t pos, size_t n, TokenKind& kind) const {
+        const string* p = &dfa.start;
+        while (pos < n) {
+            auto row = dfa.transitions.find(*p);
+            if (row == dfa.transitions.end()) break;
+            auto to = row->second.find(static_cast<char>(s[pos]));
+            if (to == row->second.end()) break;
+            p = &to->second;
+            pos++;
+        }
+        auto accepted = dfa.accept.find(*p);
+        kind = accepted == dfa.accept.end() ? TK_NONE : accepted->second;
+        return pos;
+    }
+};
+
+struct Lexer {
+    const char* name;
+    bool (*scan)(string_view input, vector<Token>& tokens);
+};
+
+template <typename Matcher>
+bool scanWith(string_view input, vector<Token>& tokens) {
+    return scanRange<Matcher>(input, 0, input.length(), tokens);
+}
+
+const Lexer LEXERS[] = {
+    {"map", scanWith<MapMatcher>},
+    {"table", scanWith<TableMatcher>},
+#ifdef WLP4_DIRECT_LEXER
+    {"direct", scanWith<DirectMatcher>},
+#endif
+};
+
+bool sameTokens(const vector<Token>& a, const vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].kind != b[i].kind || a[i].offset != b[i].offset || a[i].length != b[i].length) return false;
+    }
+    return true;
+}
+
+// Best wall time of rounds calls of run, in seconds
+template <typename Run>
+double bestSeconds(unsigned rounds, Run run) {
+    double best = 0;
+    for (unsigned i = 0; i < rounds; ++i) {
+        auto start = chrono::steady_clock::now();
+        run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    unsigned rounds = 5;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        string_view arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            maxThreads = max(1ul, strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            rounds = max(1ul, strtoul(argv[++i], nullptr, 10));
+        } else {
+            path = argv[i];
+        }
+    }
+
+    int fd = STDIN_FILENO;
+    if (path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "ERROR: cannot open " << path << endl;
+            return 1;
+        }
+    }
+    SourceBuffer source(fd);
+    if (fd != STDIN_FILENO) close(fd);
+    string_view input = source.view();
+
+    vector<Token> expected;
+    if (!scanTokens(input, expected)) {
+        cerr << "ERROR" << endl;
+        return 1;
+    }
+    cout << input.length() << " bytes, " << expected.size() << " tokens, best of " << rounds << endl;
+
+    bool failed = false;
+    double mapSeconds = 0;
+    for (const Lexer& lexer : LEXERS) {
+        vector<Token> tokens;
+        double seconds = bestSeconds(rounds, [&] {
+            tokens.clear();
+            lexer.scan(input, tokens);
+        });
+        if (mapSeconds == 0) mapSeconds = seconds;
+        bool same = sameTokens(tokens, expected);
+        failed = failed || !same;
+        cout << setw(11) << lexer.name << ' ' << fixed << setprecision(2)
+             << setw(9) << seconds * 1000 << " ms " << setw(9) << input.length() / seconds / 1e6 << " MB/s "
+             << setw(6) << mapSeconds / seconds << "x" << (same ? "" : "  MISMATCH") << endl;
+    }
+#ifndef WLP4_DIRECT_LEXER
+    cout << "     direct (build with -DWLP4_DIRECT_LEXER)" << endl;
+#endif
+
+    vector<unsigned> counts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(maxThreads);
+
+    double oneThread = 0;
+    for (unsigned threads : counts) {
+        vector<Token> tokens;
+        double seconds = bestSeconds(rounds, [&] {
+            tokens.clear();
+            scanTokensParallel(input, threads, tokens);
+        });
+        if (threads == 1) oneThread = seconds;
+        bool same = sameTokens(tokens, expected);
+        failed = failed || !same;
+        cout << setw(3) << threads << " threads " << fixed << setprecision(2)
+             << setw(9) << seconds * 1000 << " ms " << setw(9) << input.length() / seconds / 1e6 << " MB/s "
+             << setw(6) << oneThread / seconds << "x" << (same ? "" : "  MISMATCH") << endl;
+    }
+    return failed ? 1 : 0;
+}
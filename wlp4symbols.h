@@ -0,0 +1,57 @@
+#ifndef WLP4SYMBOLS_H
+#define WLP4SYMBOLS_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+
+constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+
+// Interning table: gives each distinct string a dense uint32_t ID in order
+// of first appearance, so stages can compare lexemes as integers and keep
+// per-symbol data in vectors indexed by ID.
+class SymbolTable {
+  std::deque<std::string> names;  // deque: elements never move, so the keys below stay valid
+  std::unordered_map<std::string_view, uint32_t> ids;
+
+public:
+  // Moving a table keeps its strings where they are; a copy would keep
+  // keys into the original's
+  SymbolTable() = default;
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable& operator=(const SymbolTable&) = delete;
+  SymbolTable(SymbolTable&&) = default;
+  SymbolTable& operator=(SymbolTable&&) = default;
+
+  uint32_t intern(std::string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.emplace_back(name);
+    ids.emplace(names.back(), id);
+    return id;
+  }
+
+  // ID of an already interned string, or NO_SYMBOL
+  uint32_t find(std::string_view name) const {
+    auto it = ids.find(name);
+    return it == ids.end() ? NO_SYMBOL : it->second;
+  }
+
+  const std::string& name(uint32_t id) const {
+    return names[id];
+  }
+
+  size_t size() const {
+    return names.size();
+  }
+
+  void clear() {
+    ids.clear();
+    names.clear();
+  }
+};
+
+#endif
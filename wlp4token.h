@@ -0,0 +1,126 @@
+#ifndef WLP4TOKEN_H
+#define WLP4TOKEN_H
+
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+
+// Token kinds shared by the WLP4 tools, printed through TOKEN_KIND_NAMES
+enum TokenKind : uint8_t {
+  TK_NONE,
+  TK_ID, TK_NUM,
+  TK_LPAREN, TK_RPAREN, TK_LBRACE, TK_RBRACE, TK_LBRACK, TK_RBRACK,
+  TK_BECOMES, TK_EQ, TK_NE, TK_LT, TK_GT, TK_LE, TK_GE,
+  TK_PLUS, TK_MINUS, TK_STAR, TK_SLASH, TK_PCT, TK_COMMA, TK_SEMI, TK_AMP,
+  TK_WAIN, TK_INT, TK_IF, TK_ELSE, TK_WHILE, TK_PRINTLN, TK_PUTCHAR,
+  TK_GETCHAR, TK_RETURN, TK_NULL, TK_NEW, TK_DELETE,
+  TK_COUNT
+};
+
+constexpr std::string_view TOKEN_KIND_NAMES[TK_COUNT] = {
+  "UNKNOWN",
+  "ID", "NUM",
+  "LPAREN", "RPAREN", "LBRACE", "RBRACE", "LBRACK", "RBRACK",
+  "BECOMES", "EQ", "NE", "LT", "GT", "LE", "GE",
+  "PLUS", "MINUS", "STAR", "SLASH", "PCT", "COMMA", "SEMI", "AMP",
+  "WAIN", "INT", "IF", "ELSE", "WHILE", "PRINTLN", "PUTCHAR",
+  "GETCHAR", "RETURN", "NULL", "NEW", "DELETE"
+};
+
+// Fixed lexeme of each token kind; empty for ID and NUM, whose lexemes vary
+constexpr std::string_view TOKEN_SPELLINGS[TK_COUNT] = {
+  "",
+  "", "",
+  "(", ")", "{", "}", "[", "]",
+  "=", "==", "!=", "<", ">", "<=", ">=",
+  "+", "-", "*", "/", "%", ",", ";", "&",
+  "wain", "int", "if", "else", "while", "println", "putchar",
+  "getchar", "return", "NULL", "new", "delete"
+};
+
+struct Keyword {
+  std::string_view text;
+  TokenKind kind;
+};
+
+constexpr Keyword KEYWORDS[] = {
+  {"wain", TK_WAIN}, {"int", TK_INT}, {"if", TK_IF}, {"else", TK_ELSE},
+  {"while", TK_WHILE}, {"println", TK_PRINTLN}, {"putchar", TK_PUTCHAR},
+  {"getchar", TK_GETCHAR}, {"return", TK_RETURN}, {"NULL", TK_NULL},
+  {"new", TK_NEW}, {"delete", TK_DELETE}
+};
+
+constexpr size_t KEYWORD_COUNT = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+
+// Minimal perfect hash over KEYWORDS:
+//   slot = (length + firstValue[first char] + lastValue[last char]) % KEYWORD_COUNT
+// The two value tables are found at compile time by backtracking search.
+struct KeywordHash {
+  uint8_t firstValue[256] = {};
+  uint8_t lastValue[256] = {};
+  bool firstSet[256] = {};
+  bool lastSet[256] = {};
+  bool slotUsed[KEYWORD_COUNT] = {};
+  Keyword slots[KEYWORD_COUNT] = {};
+  size_t minLength = SIZE_MAX;
+  size_t maxLength = 0;
+
+  constexpr size_t slot(size_t length, unsigned char first, unsigned char last) const {
+    return (length + firstValue[first] + lastValue[last]) % KEYWORD_COUNT;
+  }
+};
+
+constexpr bool assignKeywordSlots(KeywordHash& hash, size_t i) {
+  if (i == KEYWORD_COUNT) return true;
+  const Keyword& keyword = KEYWORDS[i];
+  unsigned char first = keyword.text.front();
+  unsigned char last = keyword.text.back();
+  bool freeFirst = !hash.firstSet[first];
+  bool freeLast = !hash.lastSet[last];
+
+  for (size_t a = 0; a < (freeFirst ? KEYWORD_COUNT : 1); ++a) {
+    for (size_t b = 0; b < (freeLast ? KEYWORD_COUNT : 1); ++b) {
+      if (freeFirst) hash.firstValue[first] = a;
+      if (freeLast) hash.lastValue[last] = b;
+      hash.firstSet[first] = hash.lastSet[last] = true;
+      size_t s = hash.slot(keyword.text.length(), first, last);
+      if (!hash.slotUsed[s]) {
+        hash.slotUsed[s] = true;
+        hash.slots[s] = keyword;
+        if (assignKeywordSlots(hash, i + 1)) return true;
+        hash.slotUsed[s] = false;
+      }
+      if (freeFirst) hash.firstSet[first] = false;
+      if (freeLast) hash.lastSet[last] = false;
+    }
+  }
+  return false;
+}
+
+constexpr KeywordHash buildKeywordHash() {
+  KeywordHash hash;
+  if (!assignKeywordSlots(hash, 0)) throw "no perfect hash for the keyword set";
+  for (const Keyword& keyword : KEYWORDS) {
+    if (keyword.text.length() < hash.minLength) hash.minLength = keyword.text.length();
+    if (keyword.text.length() > hash.maxLength) hash.maxLength = keyword.text.length();
+  }
+  return hash;
+}
+
+constexpr KeywordHash KEYWORD_HASH = buildKeywordHash();
+
+// Kind of an identifier-shaped lexeme: its keyword kind, or TK_ID.
+// One table probe and one memcmp.
+inline TokenKind classifyIdentifier(std::string_view lexeme) {
+  size_t length = lexeme.length();
+  if (length < KEYWORD_HASH.minLength || length > KEYWORD_HASH.maxLength) return TK_ID;
+  const Keyword& candidate = KEYWORD_HASH.slots[KEYWORD_HASH.slot(
+      length, lexeme.front(), lexeme.back())];
+  if (candidate.text.length() == length &&
+      std::memcmp(candidate.text.data(), lexeme.data(), length) == 0) {
+    return candidate.kind;
+  }
+  return TK_ID;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef WLP4TOKSTREAM_H
+#define WLP4TOKSTREAM_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "wlp4token.h"
+#include "wlp4symbols.h"
+
+// Binary token stream between wlp4scan and wlp4parse (--binary). A stream
+// is one or more frames (wlp4scan --stream writes one per block):
+//
+//   header   magic "WLTK", uint32 version, uint32 token count,
+//            uint32 symbol count, uint32 blob size
+//   symbols  symbol count x {uint32 offset, uint32 length} into the blob
+//   records  token count x {uint8 kind, uint32 symbol}
+//   blob     text of the symbols
+//
+// Every distinct lexeme of a frame is a symbol with a dense ID in order of
+// first appearance in the frame. Each frame has its own table, so the
+// writer only holds one frame's lexemes however long the stream is. The
+// reader merges the frames' tables into one, which gives every distinct
+// lexeme of the stream one ID in order of first appearance. Integers are
+// little-endian and records are packed to 5 bytes.
+
+constexpr char TOKEN_STREAM_MAGIC[4] = {'W', 'L', 'T', 'K'};
+constexpr uint32_t TOKEN_STREAM_VERSION = 3;
+constexpr size_t TOKEN_STREAM_HEADER_SIZE = 20;
+constexpr size_t TOKEN_SYMBOL_ENTRY_SIZE = 8;
+constexpr size_t TOKEN_RECORD_SIZE = 5;
+
+struct TokenRecord {
+  TokenKind kind;
+  uint32_t symbol;  // lexeme, as an ID in the frame's (writer) or the stream's (reader) SymbolTable
+};
+
+inline void putU32(char* out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) out[i] = static_cast<char>(value >> (8 * i));
+}
+
+inline uint32_t getU32(const char* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+  return value;
+}
+
+// Interns lexemes and collects tokens. Each write() emits one frame holding
+// the tokens added since the previous write() and their symbols, then
+// starts a new table.
+class TokenStreamWriter {
+  SymbolTable symbols;
+  std::vector<TokenRecord> records;
+
+public:
+  void add(TokenKind kind, std::string_view lexeme) {
+    records.push_back({kind, symbols.intern(lexeme)});
+  }
+
+  void write(std::ostream& out) {
+    std::string section(symbols.size() * TOKEN_SYMBOL_ENTRY_SIZE + records.size() * TOKEN_RECORD_SIZE, '\0');
+    std::string blob;
+    char* p = &section[0];
+    for (size_t id = 0; id < symbols.size(); ++id) {
+      const std::string& name = symbols.name(id);
+      putU32(p, static_cast<uint32_t>(blob.size()));
+      putU32(p + 4, static_cast<uint32_t>(name.size()));
+      blob += name;
+      p += TOKEN_SYMBOL_ENTRY_SIZE;
+    }
+    for (const TokenRecord& record : records) {
+      p[0] = static_cast<char>(record.kind);
+      putU32(p + 1, record.symbol);
+      p += TOKEN_RECORD_SIZE;
+    }
+
+    char header[TOKEN_STREAM_HEADER_SIZE];
+    std::memcpy(header, TOKEN_STREAM_MAGIC, 4);
+    putU32(header + 4, TOKEN_STREAM_VERSION);
+    putU32(header + 8, static_cast<uint32_t>(records.size()));
+    putU32(header + 12, static_cast<uint32_t>(symbols.size()));
+    putU32(header + 16, static_cast<uint32_t>(blob.size()));
+    out.write(header, sizeof(header));
+    out.write(section.data(), section.size());
+    out.write(blob.data(), blob.size());
+
+    symbols.clear();
+    records.clear();
+  }
+};
+
+// Reads a whole binary token stream into records and an initially empty
+// symbol table, merging the tables of its frames. Returns false if the
+// stream is malformed.
+inline bool readTokenStream(std::istream& in, std::vector<TokenRecord>& records, SymbolTable& symbols) {
+  records.clear();
+  bool sawFrame = false;
+  char header[TOKEN_STREAM_HEADER_SIZE];
+  std::vector<uint32_t> frameSymbols;  // frame's symbol ID -> stream's
+  while (in.read(header, sizeof(header))) {
+    if (std::memcmp(header, TOKEN_STREAM_MAGIC, 4) != 0) return false;
+    if (getU32(header + 4) != TOKEN_STREAM_VERSION) return false;
+    uint32_t count = getU32(header + 8);
+    uint32_t symbolCount = getU32(header + 12);
+    uint32_t blobSize = getU32(header + 16);
+
+    std::string section(static_cast<size_t>(symbolCount) * TOKEN_SYMBOL_ENTRY_SIZE +
+                        static_cast<size_t>(count) * TOKEN_RECORD_SIZE, '\0');
+    std::string blob(blobSize, '\0');
+    if (!in.read(&section[0], section.size()) || !in.read(&blob[0], blob.size())) return false;
+
+    const char* p = section.data();
+    frameSymbols.resize(symbolCount);
+    for (uint32_t i = 0; i < symbolCount; ++i, p += TOKEN_SYMBOL_ENTRY_SIZE) {
+      uint32_t offset = getU32(p);
+      uint32_t length = getU32(p + 4);
+      if (offset > blobSize || length > blobSize - offset) return false;
+      frameSymbols[i] = symbols.intern(std::string_view(blob).substr(offset, length));
+    }
+
+    records.reserve(records.size() + count);
+    for (uint32_t i = 0; i < count; ++i, p += TOKEN_RECORD_SIZE) {
+      TokenRecord record{static_cast<TokenKind>(static_cast<unsigned char>(p[0])), getU32(p + 1)};
+      if (record.kind == TK_NONE || record.kind >= TK_COUNT) return false;
+      if (record.symbol >= symbolCount) return false;
+      record.symbol = frameSymbols[record.symbol];
+      records.push_back(record);
+    }
+    sawFrame = true;
+  }
+  return sawFrame && in.gcount() == 0;
+}
+
+#endif
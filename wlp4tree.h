@@ -0,0 +1,321 @@
+#ifndef WLP4TREE_H
+#define WLP4TREE_H
+
+#include <deque>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "wlp4symbols.h"
+#include "wlp4token.h"
+#include "wlp4treestream.h"
+
+// Parse tree as wlp4type and wlp4gen read it: wlp4parse output (.wlp4i) or
+// wlp4type output (.wlp4ti), one node per line in preorder, a rule line
+// followed by one subtree per RHS symbol other than .EMPTY, and an optional
+// " : type" at the end of a line.
+//
+// The left-recursive lists are normalized on read. A statements or dcls
+// chain of N nested nodes becomes one list node that keeps the levels in
+// a vector in source order:
+//   items[i]  the i-th level, a node for its recursive rule whose children
+//             are the rule's other slots (statement; dcl BECOMES NUM SEMI)
+//   base      the innermost node (statements .EMPTY, dcls .EMPTY)
+// A list node keeps the rule of the outermost level and has no children of
+// its own. An empty list is just its base rule node. The walks below step
+// through lists in the order of the text, so writeTree() gives back the
+// canonical lines.
+//
+// The same tree can come from and go to the binary form in
+// wlp4treestream.h instead of text.
+//
+// Lexemes are interned in the tree's symbol table (see wlp4symbols.h), so
+// the checker and generator index their tables by lexeme ID.
+
+// Left-recursive list nonterminals that are flattened
+constexpr std::string_view TREE_LIST_SYMBOLS[] = {"statements", "dcls"};
+
+struct TreeNode {
+  std::string_view rule;       // production, for rule nodes
+  std::string_view tokenKind;  // token kind or .EMPTY, for token nodes
+  std::string_view lexeme;     // in the tree's symbol table
+  uint32_t lexemeId = NO_SYMBOL;
+  std::string type;       // annotation after " : ", if any
+  std::vector<TreeNode*> children;
+  std::vector<TreeNode*> items;  // list nodes only
+  TreeNode* base = nullptr;      // list nodes only
+
+  bool isTerminal() const { return !tokenKind.empty(); }
+  bool isList() const { return !items.empty(); }
+};
+
+// The token kind word starts a token line with, in static storage; empty
+// if word starts a rule line
+inline std::string_view treeTokenKind(std::string_view word) {
+  for (std::string_view kind : {"BOF", "EOF", ".EMPTY"}) {
+    if (kind == word) return kind;
+  }
+  for (int kind = TK_ID; kind < TK_COUNT; ++kind) {
+    if (TOKEN_KIND_NAMES[kind] == word) return TOKEN_KIND_NAMES[kind];
+  }
+  return {};
+}
+
+// Whether rule recurses on its lhs in its first slot, for a list symbol
+inline bool isTreeListRule(std::string_view rule) {
+  size_t space = rule.find(' ');
+  if (space == std::string_view::npos) return false;
+  std::string_view lhs = rule.substr(0, space);
+  std::string_view rest = rule.substr(space + 1);
+  bool list = false;
+  for (std::string_view name : TREE_LIST_SYMBOLS) list = list || lhs == name;
+  return list && rest.substr(0, rest.find(' ')) == lhs;
+}
+
+// Owns the nodes of one tree; they live in a deque, so pointers to them
+// stay valid and freeing the tree does not recurse. Each distinct rule
+// line is stored once and shared by the nodes that use it.
+class ParseTree {
+  std::deque<TreeNode> nodes;
+  std::unordered_set<std::string> rules;
+
+  TreeNode* newNode() {
+    nodes.emplace_back();
+    return &nodes.back();
+  }
+
+  // Fills node from one line and returns how many child lines follow it
+  int parseLine(std::string_view line, TreeNode& node) {
+    size_t colon = line.find(" : ");
+    if (colon != std::string_view::npos) {
+      node.type = line.substr(colon + 3);
+      line = line.substr(0, colon);
+    }
+    size_t space = line.find(' ');
+    node.tokenKind = treeTokenKind(line.substr(0, space));
+    if (!node.tokenKind.empty()) {
+      if (space != std::string_view::npos) setLexeme(node, lexemes.intern(line.substr(space + 1)));
+      return 0;
+    }
+    node.rule = *rules.emplace(line).first;
+    int childCount = 0;
+    while (space != std::string_view::npos) {
+      line = line.substr(space + 1);
+      space = line.find(' ');
+      if (line.substr(0, space) != ".EMPTY") childCount++;
+    }
+    return childCount;
+  }
+
+  // A complete list level folds its inner level into a list node, which
+  // it then becomes
+  void finish(TreeNode* node) {
+    if (node->children.empty() || !isTreeListRule(node->rule)) return;
+    TreeNode* inner = node->children.front();
+    TreeNode* item;
+    if (inner->isList()) {
+      node->items = std::move(inner->items);
+      node->base = inner->base;
+      item = inner;
+      *item = TreeNode();
+    } else {
+      node->base = inner;
+      item = newNode();
+    }
+    item->rule = node->rule;
+    item->type = std::move(node->type);
+    item->children.assign(node->children.begin() + 1, node->children.end());
+    node->type.clear();
+    node->children.clear();
+    node->items.push_back(item);
+  }
+
+ public:
+  TreeNode* root = nullptr;
+  SymbolTable lexemes;
+
+  void setLexeme(TreeNode& node, uint32_t id) const {
+    node.lexemeId = id;
+    node.lexeme = lexemes.name(id);
+  }
+
+  // Builds the tree from its nodes in preorder, taking each from
+  // nextNode(node), which fills node and returns its child count, or -1 if
+  // there are no more nodes. Returns null if the nodes run out before
+  // every node has all its children, as in a truncated tree.
+  template <class NextNode>
+  TreeNode* build(NextNode nextNode) {
+    nodes.clear();
+    root = newNode();
+    int childCount = nextNode(*root);
+    if (childCount < 0) return root = nullptr;
+
+    std::vector<std::pair<TreeNode*, int>> pending;  // node, children still to read
+    if (childCount > 0) {
+      pending.push_back({root, childCount});
+    } else {
+      finish(root);
+    }
+    TreeNode* child = nullptr;
+    while (!pending.empty()) {
+      TreeNode* parent = pending.back().first;
+      if (pending.back().second == 0) {
+        finish(parent);
+        pending.pop_back();
+        continue;
+      }
+      pending.back().second--;
+      if (!child) child = newNode();
+      childCount = nextNode(*child);
+      if (childCount < 0) return root = nullptr;
+      parent->children.push_back(child);
+      if (childCount > 0) {
+        pending.push_back({child, childCount});
+      } else {
+        finish(child);
+      }
+      child = nullptr;
+    }
+    return root;
+  }
+
+  // Reads a whole tree, taking lines from nextLine(std::string&) until it
+  // returns false or gives an empty line. Every rule line needs one child
+  // line per symbol of its right-hand side. Returns the root, or null if
+  // there is no first line or a child line is missing.
+  template <class NextLine>
+  TreeNode* read(NextLine nextLine) {
+    std::string line;
+    return build([&](TreeNode& node) {
+      if (!nextLine(line) || line.empty()) return -1;
+      return parseLine(line, node);
+    });
+  }
+
+  // Reads the tree of a binary stream that TreeStreamView::open() accepted
+  TreeNode* read(const TreeStreamView& stream) {
+    uint32_t next = 0;
+    return build([&](TreeNode& node) {
+      if (next == stream.size()) return -1;
+      TreeRecord record = stream.node(next++);
+      if (record.kind == TREE_RULE) {
+        node.rule = WLP4_PARSE_TABLES.rules[record.value].text;
+      } else {
+        node.tokenKind = WLP4_PARSE_TABLES.symbolNames[record.value];
+        setLexeme(node, lexemes.intern(stream.lexeme(record.lexeme)));
+      }
+      node.type = TREE_TYPE_NAMES[record.type];
+      return static_cast<int>(record.childCount);
+    });
+  }
+};
+
+// Visits the nodes in the order of their lines, with an explicit stack.
+// visit(node, parent) returns false to end the walk, in which case so
+// does walkPreorder. List nodes are not visited themselves; their items
+// and base are, with the list's parent as the items' parent.
+template <class Visit>
+bool walkPreorder(TreeNode* root, Visit visit) {
+  if (!root) return true;
+  struct Step {
+    TreeNode* node;
+    TreeNode* parent;
+    bool lineOnly;  // a list level, whose children come after the base
+  };
+  std::vector<Step> pending = {{root, nullptr, false}};
+  while (!pending.empty()) {
+    Step step = pending.back();
+    pending.pop_back();
+    TreeNode* node = step.node;
+    if (node->isList()) {
+      // Pushed so that they pop as: the levels outermost first, the base,
+      // then the children of each level in source order
+      for (auto item = node->items.rbegin(); item != node->items.rend(); ++item) {
+        for (auto child = (*item)->children.rbegin(); child != (*item)->children.rend(); ++child) {
+          pending.push_back({*child, *item, false});
+        }
+      }
+      pending.push_back({node->base, node->items.front(), false});
+      for (TreeNode* item : node->items) pending.push_back({item, step.parent, true});
+      continue;
+    }
+    if (!visit(node, step.parent)) return false;
+    if (step.lineOnly) continue;
+    for (auto child = node->children.rbegin(); child != node->children.rend(); ++child) {
+      pending.push_back({*child, node, false});
+    }
+  }
+  return true;
+}
+
+// Calls visit(node) on every node after its children, with an explicit
+// stack. A list's base comes first, then each level after its children.
+template <class Visit>
+void walkPostorder(TreeNode* root, Visit visit) {
+  if (!root) return;
+  std::vector<std::pair<TreeNode*, bool>> pending = {{root, false}};  // node, children done
+  while (!pending.empty()) {
+    auto [node, childrenDone] = pending.back();
+    pending.pop_back();
+    if (childrenDone) {
+      visit(node);
+    } else if (node->isList()) {
+      for (auto item = node->items.rbegin(); item != node->items.rend(); ++item) pending.push_back({*item, false});
+      pending.push_back({node->base, false});
+    } else {
+      pending.push_back({node, true});
+      for (auto child = node->children.rbegin(); child != node->children.rend(); ++child) {
+        pending.push_back({*child, false});
+      }
+    }
+  }
+}
+
+// Whether the type of node is part of the tree's output: it is for tokens
+// and for expr, term, factor and lvalue nodes
+inline bool showsType(const TreeNode* node) {
+  if (node->type.empty()) return false;
+  if (node->isTerminal()) return true;
+  std::string_view lhs = node->rule.substr(0, node->rule.find(' '));
+  return lhs == "expr" || lhs == "term" || lhs == "factor" || lhs == "lvalue";
+}
+
+// Writes the tree in the .wlp4ti text form
+inline void writeTree(std::ostream& out, TreeNode* root) {
+  walkPreorder(root, [&](TreeNode* node, TreeNode*) {
+    if (node->isTerminal()) {
+      out << node->tokenKind;
+      if (!node->lexeme.empty()) out << ' ' << node->lexeme;
+    } else {
+      out << node->rule;
+    }
+    if (showsType(node)) out << " : " << node->type;
+    out << '\n';
+    return true;
+  });
+}
+
+// Writes the tree as a binary stream; false if it has a node the stream
+// cannot hold, such as a rule that is not in the grammar
+inline bool writeTreeStream(std::ostream& out, TreeNode* root) {
+  TreeStreamWriter writer;
+  bool ok = walkPreorder(root, [&](TreeNode* node, TreeNode*) {
+    TreeType type = showsType(node) ? treeType(node->type) : TREE_UNTYPED;
+    if (node->isTerminal()) {
+      int symbol = terminalSymbol(node->tokenKind);
+      if (symbol == TK_NONE) return false;
+      writer.addToken(symbol, node->lexeme, type);
+    } else {
+      int rule = ruleIndex(node->rule);
+      if (rule < 0) return false;
+      writer.addRule(rule, type);
+    }
+    return true;
+  });
+  if (ok) writer.write(out);
+  return ok;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef WLP4TREESTREAM_H
+#define WLP4TREESTREAM_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "wlp4grammar.h"
+#include "wlp4symbols.h"
+#include "wlp4tokstream.h"
+
+// Binary parse tree between wlp4parse, wlp4type and wlp4gen
+// (--binary-tree), in place of the text lines:
+//
+//   header   magic "WLPT", uint32 version, uint32 node count,
+//            uint32 string count, uint32 blob size
+//   strings  string count x {uint32 offset, uint32 length} into the blob
+//   nodes    node count x {uint8 kind, uint8 value, uint8 type,
+//            uint8 child count, uint32 lexeme}
+//   blob     text of the strings
+//
+// The nodes are in preorder, like the lines of the text form. A rule
+// node's value is its index in WLP4_PARSE_TABLES.rules and its child count
+// is the rule's length; a token's value is its terminal symbol (a token
+// kind, SYM_BOF or SYM_EOF) and its lexeme is a string index. Lexemes are
+// interned, so each distinct one is stored once. Every section has fixed
+// size entries, so TreeStreamView can walk a mapped file in place.
+// Integers are little-endian.
+
+constexpr char TREE_STREAM_MAGIC[4] = {'W', 'L', 'P', 'T'};
+constexpr uint32_t TREE_STREAM_VERSION = 1;
+constexpr size_t TREE_STREAM_HEADER_SIZE = 20;
+constexpr size_t TREE_STRING_ENTRY_SIZE = 8;
+constexpr size_t TREE_RECORD_SIZE = 8;
+
+static_assert(MAX_GRAMMAR_SYMBOLS <= 256 && MAX_RULES <= 256 && MAX_RHS <= 256,
+              "tree records keep symbols, rules and child counts in one byte");
+
+enum TreeRecordKind : uint8_t { TREE_RULE, TREE_TOKEN };
+
+// Type annotation of a node, as wlp4type writes it
+enum TreeType : uint8_t { TREE_UNTYPED, TREE_INT, TREE_INT_POINTER, TREE_TYPE_COUNT };
+
+constexpr std::string_view TREE_TYPE_NAMES[TREE_TYPE_COUNT] = {"", "int", "int*"};
+
+inline TreeType treeType(std::string_view name) {
+  for (int type = TREE_INT; type < TREE_TYPE_COUNT; ++type) {
+    if (TREE_TYPE_NAMES[type] == name) return static_cast<TreeType>(type);
+  }
+  return TREE_UNTYPED;
+}
+
+// Index of the rule with this production text, or -1
+inline int ruleIndex(std::string_view text) {
+  static const std::unordered_map<std::string_view, int> ids = [] {
+    std::unordered_map<std::string_view, int> ids;
+    for (int r = 0; r < WLP4_PARSE_TABLES.ruleCount; ++r) ids.emplace(WLP4_PARSE_TABLES.rules[r].text, r);
+    return ids;
+  }();
+  auto it = ids.find(text);
+  return it == ids.end() ? -1 : it->second;
+}
+
+struct TreeRecord {
+  TreeRecordKind kind;
+  uint8_t value;       // rule index or terminal symbol
+  TreeType type;
+  uint8_t childCount;
+  uint32_t lexeme;     // tokens only, as a string index
+};
+
+// Collects the nodes of one tree in preorder and writes them as a stream
+class TreeStreamWriter {
+  SymbolTable strings;
+  std::vector<TreeRecord> records;
+
+public:
+  void addRule(int rule, TreeType type = TREE_UNTYPED) {
+    records.push_back({TREE_RULE, static_cast<uint8_t>(rule), type, WLP4_PARSE_TABLES.rules[rule].length, 0});
+  }
+
+  void addToken(int symbol, std::string_view lexeme, TreeType type = TREE_UNTYPED) {
+    records.push_back({TREE_TOKEN, static_cast<uint8_t>(symbol), type, 0, strings.intern(lexeme)});
+  }
+
+  void write(std::ostream& out) {
+    std::string section(strings.size() * TREE_STRING_ENTRY_SIZE + records.size() * TREE_RECORD_SIZE, '\0');
+    std::string blob;
+    char* p = &section[0];
+    for (size_t id = 0; id < strings.size(); ++id) {
+      const std::string& text = strings.name(id);
+      putU32(p, static_cast<uint32_t>(blob.size()));
+      putU32(p + 4, static_cast<uint32_t>(text.size()));
+      blob += text;
+      p += TREE_STRING_ENTRY_SIZE;
+    }
+    for (const TreeRecord& record : records) {
+      p[0] = static_cast<char>(record.kind);
+      p[1] = static_cast<char>(record.value);
+      p[2] = static_cast<char>(record.type);
+      p[3] = static_cast<char>(record.childCount);
+      putU32(p + 4, record.lexeme);
+      p += TREE_RECORD_SIZE;
+    }
+
+    char header[TREE_STREAM_HEADER_SIZE];
+    std::memcpy(header, TREE_STREAM_MAGIC, 4);
+    putU32(header + 4, TREE_STREAM_VERSION);
+    putU32(header + 8, static_cast<uint32_t>(records.size()));
+    putU32(header + 12, static_cast<uint32_t>(strings.size()));
+    putU32(header + 16, static_cast<uint32_t>(blob.size()));
+    out.write(header, sizeof(header));
+    out.write(section.data(), section.size());
+    out.write(blob.data(), blob.size());
+  }
+};
+
+// Reads a tree stream where it lies, without copying it
+class TreeStreamView {
+  const char* strings = nullptr;
+  const char* records = nullptr;
+  const char* blob = nullptr;
+  uint32_t nodeCount = 0;
+  uint32_t stringCount = 0;
+
+public:
+  // Checks that data is exactly one well-formed tree; data must outlive
+  // the view
+  bool open(std::string_view data) {
+    if (data.size() < TREE_STREAM_HEADER_SIZE) return false;
+    const char* header = data.data();
+    if (std::memcmp(header, TREE_STREAM_MAGIC, 4) != 0) return false;
+    if (getU32(header + 4) != TREE_STREAM_VERSION) return false;
+    nodeCount = getU32(header + 8);
+    stringCount = getU32(header + 12);
+    uint32_t blobSize = getU32(header + 16);
+    if (data.size() != TREE_STREAM_HEADER_SIZE + static_cast<size_t>(stringCount) * TREE_STRING_ENTRY_SIZE +
+                           static_cast<size_t>(nodeCount) * TREE_RECORD_SIZE + blobSize) {
+      return false;
+    }
+    strings = header + TREE_STREAM_HEADER_SIZE;
+    records = strings + static_cast<size_t>(stringCount) * TREE_STRING_ENTRY_SIZE;
+    blob = records + static_cast<size_t>(nodeCount) * TREE_RECORD_SIZE;
+
+    for (uint32_t id = 0; id < stringCount; ++id) {
+      uint32_t offset = getU32(strings + id * TREE_STRING_ENTRY_SIZE);
+      uint32_t length = getU32(strings + id * TREE_STRING_ENTRY_SIZE + 4);
+      if (offset > blobSize || length > blobSize - offset) return false;
+    }
+
+    // Preorder: one node is owed at the start, and each node pays one and
+    // owes its children
+    uint64_t owed = 1;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+      if (owed == 0) return false;
+      TreeRecord record = node(i);
+      if (record.type >= TREE_TYPE_COUNT) return false;
+      if (record.kind == TREE_RULE) {
+        if (record.value >= WLP4_PARSE_TABLES.ruleCount) return false;
+        if (record.childCount != WLP4_PARSE_TABLES.rules[record.value].length) return false;
+      } else if (record.kind == TREE_TOKEN) {
+        if (record.value == TK_NONE || record.value > SYM_EOF) return false;
+        if (record.childCount != 0 || record.lexeme >= stringCount) return false;
+      } else {
+        return false;
+      }
+      owed = owed - 1 + record.childCount;
+    }
+    return nodeCount > 0 && owed == 0;
+  }
+
+  uint32_t size() const {
+    return nodeCount;
+  }
+
+  TreeRecord node(uint32_t i) const {
+    const char* p = records + static_cast<size_t>(i) * TREE_RECORD_SIZE;
+    return {static_cast<TreeRecordKind>(static_cast<unsigned char>(p[0])), static_cast<uint8_t>(p[1]),
+            static_cast<TreeType>(static_cast<unsigned char>(p[2])), static_cast<uint8_t>(p[3]), getU32(p + 4)};
+  }
+
+  std::string_view lexeme(uint32_t id) const {
+    const char* entry = strings + static_cast<size_t>(id) * TREE_STRING_ENTRY_SIZE;
+    return std::string_view(blob + getU32(entry), getU32(entry + 4));
+  }
+};
+
+#endif
@@ -0,0 +1,859 @@
+#ifndef WLP4TYPECHECKER_H
+#define WLP4TYPECHECKER_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include "wlp4tree.h"
+
+// Semantic analysis of wlp4type and wlp4c: checks a parse tree (see
+// wlp4tree.h) and annotates its expressions and IDs with their types.
+
+// Expression nodes are terminals (NUM, NULL, ID) or nonterminals (expr, term, factor, lvalue)
+inline bool isExpression(const TreeNode* node) {
+    if (node->isTerminal()) {
+        return node->tokenKind == "NUM" || node->tokenKind == "NULL" || node->tokenKind == "ID";
+    }
+    std::string_view lhs = node->rule.substr(0, node->rule.find(' '));
+    return lhs == "expr" || lhs == "term" || lhs == "factor" || lhs == "lvalue";
+}
+
+// Function to find a node with a specific rule pattern
+inline TreeNode* findNode(TreeNode* root, const std::string& pattern) {
+    TreeNode* result = nullptr;
+    walkPreorder(root, [&](TreeNode* node, TreeNode*) {
+        if (!node->isTerminal() && node->rule.find(pattern) != std::string::npos) {
+            result = node;
+            return false;
+        }
+        return true;
+    });
+    return result;
+}
+
+// Function to get the type from a type node
+inline std::string getType(TreeNode* typeNode) {
+    if (!typeNode) return "";
+
+    // Look for INT and STAR tokens in the type subtree
+    bool hasInt = false;
+    bool hasStar = false;
+
+    walkPreorder(typeNode, [&](TreeNode* node, TreeNode*) {
+        if (node->tokenKind == "INT") hasInt = true;
+        if (node->tokenKind == "STAR") hasStar = true;
+        return true;
+    });
+
+    if (hasInt && hasStar) return "int*";
+    if (hasInt) return "int";
+    return "";
+}
+
+class TypeChecker {
+    // A procedure's signature and the variables it declares, in order
+    struct ProcedureTable {
+        bool declared = false;
+        std::vector<std::string> paramTypes;
+        std::vector<std::pair<uint32_t, std::string>> variables;
+    };
+
+    // Procedure tables indexed by the lexeme ID of the name (wain's is that
+    // of its WAIN token)
+    std::vector<ProcedureTable> tables;
+
+    // Types of the current procedure's variables indexed by lexeme ID, "" for
+    // names it does not declare; enterProcedure() swaps them in and out
+    std::vector<std::string> variableTypes;
+
+    // Current procedure name being analyzed
+    uint32_t currentProcedure = NO_SYMBOL;
+
+    // The table of procedure name, or null if no such procedure is declared
+    const ProcedureTable* findProcedure(uint32_t name) const {
+        return name < tables.size() && tables[name].declared ? &tables[name] : nullptr;
+    }
+
+    // Makes name the current procedure: unloads the variables of the last
+    // one and loads those name has declared so far
+    void enterProcedure(uint32_t name) {
+        if (currentProcedure < tables.size()) {
+            for (const auto& variable : tables[currentProcedure].variables) variableTypes[variable.first].clear();
+        }
+        currentProcedure = name;
+        if (name < tables.size()) {
+            for (const auto& variable : tables[name].variables) variableTypes[variable.first] = variable.second;
+        }
+    }
+
+    // Declares a variable of the current procedure; false if it already is
+    bool declareVariable(uint32_t name, const std::string& type) {
+        if (name >= variableTypes.size() || type.empty() || !variableTypes[name].empty()) return false;
+        variableTypes[name] = type;
+        tables[currentProcedure].variables.emplace_back(name, type);
+        return true;
+    }
+
+    // How analyzeExpression() checks a node, from its rule or token kind
+    enum ExprForm {
+        FORM_NUM, FORM_NULL, FORM_ID, FORM_PLUS, FORM_MINUS, FORM_MULTIPLY, FORM_ADDRESS, FORM_DEREFERENCE,
+        FORM_NEW, FORM_CALL, FORM_CALL_ARGS, FORM_GETCHAR, FORM_TEST, FORM_PARENS, FORM_FIRST_TYPED, FORM_NONE
+    };
+
+    static ExprForm expressionForm(const TreeNode* exprNode) {
+        if (exprNode->isTerminal()) {
+            if (exprNode->tokenKind == "NUM") return FORM_NUM;
+            if (exprNode->tokenKind == "NULL") return FORM_NULL;
+            if (exprNode->tokenKind == "ID") return FORM_ID;
+            return FORM_NONE;
+        }
+        std::string_view rule = exprNode->rule;
+        if (rule.find("expr PLUS term") != std::string::npos) return FORM_PLUS;
+        if (rule.find("expr MINUS term") != std::string::npos) return FORM_MINUS;
+        if (rule.find("term STAR factor") != std::string::npos || rule.find("term SLASH factor") != std::string::npos ||
+            rule.find("term PCT factor") != std::string::npos) {
+            return FORM_MULTIPLY;
+        }
+        if (rule.find("factor AMP lvalue") != std::string::npos) return FORM_ADDRESS;
+        if (rule.find("factor STAR factor") != std::string::npos) return FORM_DEREFERENCE;
+        if (rule.find("factor NEW INT LBRACK expr RBRACK") != std::string::npos) return FORM_NEW;
+        if (rule.find("factor ID LPAREN RPAREN") != std::string::npos) return FORM_CALL;
+        if (rule.find("factor ID LPAREN arglist RPAREN") != std::string::npos) return FORM_CALL_ARGS;
+        if (rule.find("factor GETCHAR LPAREN RPAREN") != std::string::npos) return FORM_GETCHAR;
+        if (rule.find("test expr") != std::string::npos) return FORM_TEST;
+        if (rule.find("lvalue STAR factor") != std::string::npos) return FORM_DEREFERENCE;
+        if (rule.find("lvalue LPAREN lvalue RPAREN") != std::string::npos ||
+            rule.find("factor LPAREN expr RPAREN") != std::string::npos) {
+            return FORM_PARENS;
+        }
+        // Default: propagate type from first child
+        return FORM_FIRST_TYPED;
+    }
+
+    // Appends the operands whose types the type of exprNode depends on, in
+    // the order they are checked
+    void expressionOperands(TreeNode* exprNode, ExprForm form, std::vector<TreeNode*>& operands) {
+        const std::vector<TreeNode*>& children = exprNode->children;
+        switch (form) {
+            case FORM_PLUS:
+            case FORM_MINUS:
+            case FORM_MULTIPLY:
+            case FORM_TEST:
+                if (children.size() >= 3) {
+                    operands.push_back(children[0]);
+                    operands.push_back(children[2]);
+                }
+                break;
+            case FORM_ADDRESS:
+            case FORM_DEREFERENCE:
+            case FORM_PARENS:
+                if (children.size() >= 2) operands.push_back(children[1]);
+                break;
+            case FORM_NEW:
+                if (children.size() >= 4) operands.push_back(children[3]);
+                break;
+            case FORM_CALL_ARGS: {
+                // The arguments are checked only if the procedure is known
+                if (!findProcedure(children[0]->lexemeId)) break;
+                TreeNode* arglistNode = children[2];
+                while (arglistNode && arglistNode->rule.find("arglist") != std::string::npos) {
+                    if (arglistNode->rule.find("expr COMMA arglist") != std::string::npos) {
+                        operands.push_back(arglistNode->children[0]);
+                        arglistNode = arglistNode->children[2];
+                    } else {
+                        if (arglistNode->rule.find("arglist expr") != std::string::npos) {
+                            operands.push_back(arglistNode->children[0]);
+                        }
+                        break;
+                    }
+                }
+                break;
+            }
+            case FORM_FIRST_TYPED:
+                operands.insert(operands.end(), children.begin(), children.end());
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Type of exprNode given the types of the operands checked for it, or ""
+    // if it does not type check
+    std::string expressionType(TreeNode* exprNode, ExprForm form, const std::string* types, size_t count) {
+        const std::string& leftType = count > 0 ? types[0] : "";
+        const std::string& rightType = count > 1 ? types[1] : "";
+        switch (form) {
+            case FORM_NUM:
+                return "int";
+            case FORM_NULL:
+                return "int*";
+            case FORM_ID: {
+                // Variable or procedure reference; a procedure name used as an
+                // expression or an undeclared variable does not type check.
+                // Procedure name declarations and calls are typed by setIdTypes().
+                uint32_t name = exprNode->lexemeId;
+                return name < variableTypes.size() ? variableTypes[name] : "";
+            }
+            case FORM_PLUS:
+                // Addition: int + int -> int, int* + int -> int*, int + int* -> int*
+                if (count < 2 || leftType.empty() || rightType.empty()) return "";
+                if (leftType == "int" && rightType == "int") return "int";
+                if ((leftType == "int*" && rightType == "int") || (leftType == "int" && rightType == "int*")) return "int*";
+                return "";
+            case FORM_MINUS:
+                // Subtraction: int - int -> int, int* - int -> int*, int* - int* -> int
+                if (count < 2 || leftType.empty() || rightType.empty()) return "";
+                if (leftType == "int" && rightType == "int") return "int";
+                if (leftType == "int*" && rightType == "int") return "int*";
+                if (leftType == "int*" && rightType == "int*") return "int";
+                return "";
+            case FORM_MULTIPLY:
+                // Multiplication, division, modulo: int op int -> int
+                if (count < 2) return "";
+                return leftType == "int" && rightType == "int" ? "int" : "";
+            case FORM_ADDRESS:
+                // Address-of: &lvalue -> int*
+                return leftType == "int" ? "int*" : "";
+            case FORM_DEREFERENCE:
+                // Dereference: *factor -> int (if factor is int*)
+                return leftType == "int*" ? "int" : "";
+            case FORM_NEW:
+                // New array: new int[expr] -> int* (if expr is int)
+                return leftType == "int" ? "int*" : "";
+            case FORM_CALL: {
+                // Procedure call with no arguments, to a procedure declared before
+                const ProcedureTable* callee = findProcedure(exprNode->children[0]->lexemeId);
+                if (!callee || !callee->paramTypes.empty()) return "";
+                return "int";
+            }
+            case FORM_CALL_ARGS: {
+                // Procedure call with arguments; those that do not type check drop
+                // out, and the rest must match the parameters
+                const ProcedureTable* callee = findProcedure(exprNode->children[0]->lexemeId);
+                if (!callee) return "";
+                std::vector<std::string> argTypes;
+                for (size_t i = 0; i < count; i++) {
+                    if (!types[i].empty()) argTypes.push_back(types[i]);
+                }
+                return argTypes == callee->paramTypes ? "int" : "";
+            }
+            case FORM_GETCHAR:
+                // getchar() -> int
+                return "int";
+            case FORM_TEST:
+                // Test expressions (comparisons): EQ, NE, LT, LE, GE, GT
+                // Both operands must have the same type
+                if (count < 2 || leftType.empty() || rightType.empty()) return "";
+                return leftType == rightType ? "int" : "";
+            case FORM_PARENS:
+                // Parenthesized lvalue or expression
+                return leftType;
+            case FORM_FIRST_TYPED:
+                // The first child that type checks; the children after it are not checked
+                return count > 0 ? types[count - 1] : "";
+            default:
+                return "";
+        }
+    }
+
+    // Function to analyze expression type and annotate, with explicit stacks
+    // so that long operator chains and deep nesting cannot overflow the call
+    // stack. Each node is typed after its operands, as they are checked.
+    std::string analyzeExpression(TreeNode* exprNode) {
+        if (!exprNode) return "";
+
+        struct Pending {
+            TreeNode* node;
+            ExprForm form;
+            size_t firstOperand;  // into operands
+            size_t operandCount;
+            size_t checked;       // operands checked so far, their types last in types
+        };
+        std::vector<Pending> pending;
+        std::vector<TreeNode*> operands;
+        std::vector<std::string> types;
+
+        auto start = [&](TreeNode* node) {
+            ExprForm form = expressionForm(node);
+            size_t first = operands.size();
+            expressionOperands(node, form, operands);
+            pending.push_back({node, form, first, operands.size() - first, 0});
+        };
+
+        start(exprNode);
+        while (true) {
+            Pending& top = pending.back();
+            bool done = top.checked == top.operandCount ||
+                        (top.form == FORM_FIRST_TYPED && top.checked > 0 && !types.back().empty());
+            if (!done) {
+                start(operands[top.firstOperand + top.checked++]);
+                continue;
+            }
+
+            std::string type = expressionType(top.node, top.form, types.data() + types.size() - top.checked, top.checked);
+            if (!type.empty()) top.node->type = type;
+            types.resize(types.size() - top.checked);
+            operands.resize(top.firstOperand);
+            pending.pop_back();
+            if (pending.empty()) return type;
+            types.push_back(std::move(type));
+        }
+    }
+
+    // Function to analyze statements, in source order. The bodies of ifs and
+    // whiles go on an explicit stack instead of a recursive call.
+    bool analyzeStatements(TreeNode* stmtsNode) {
+        std::vector<TreeNode*> pending;  // statements still to check, the next one last
+        std::vector<TreeNode*> bodies;
+        auto schedule = [&](TreeNode* list) {
+            if (!list) return;
+            for (auto item = list->items.rbegin(); item != list->items.rend(); ++item) {
+                pending.push_back((*item)->children[0]);
+            }
+        };
+
+        schedule(stmtsNode);
+        while (!pending.empty()) {
+            TreeNode* stmtNode = pending.back();
+            pending.pop_back();
+            bodies.clear();
+            if (!analyzeStatement(stmtNode, bodies)) return false;
+            for (auto body = bodies.rbegin(); body != bodies.rend(); ++body) schedule(*body);
+        }
+        return true;
+    }
+
+    // Function to analyze a single statement; the statements lists of its
+    // body, if it has one, are added to bodies in order for the caller
+    bool analyzeStatement(TreeNode* stmtNode, std::vector<TreeNode*>& bodies) {
+        if (!stmtNode) return true;
+
+        std::string_view rule = stmtNode->rule;
+
+        if (rule.find("statement lvalue BECOMES expr SEMI") != std::string::npos) {
+            // Assignment statement
+            std::string lvalueType = analyzeExpression(stmtNode->children[0]);
+            std::string exprType = analyzeExpression(stmtNode->children[2]);
+
+            if (lvalueType.empty() || exprType.empty() || lvalueType != exprType) {
+                return false; // Type mismatch
+            }
+
+        } else if (rule.find("statement IF LPAREN test RPAREN") != std::string::npos) {
+            // If statement
+            TreeNode* testNode = stmtNode->children[2];
+            std::string testType = analyzeExpression(testNode);
+            if (testType != "int") return false; // Test must be int (boolean)
+
+            // Both branches
+            for (auto child : stmtNode->children) {
+                if (child->rule.find("statements") != std::string::npos && bodies.size() < 2) {
+                    bodies.push_back(child);
+                }
+            }
+
+        } else if (rule.find("statement WHILE LPAREN test RPAREN") != std::string::npos) {
+            // While loop
+            TreeNode* testNode = stmtNode->children[2];
+            std::string testType = analyzeExpression(testNode);
+            if (testType != "int") return false; // Test must be int (boolean)
+
+            // Body
+            for (auto child : stmtNode->children) {
+                if (child->rule.find("statements") != std::string::npos) {
+                    bodies.push_back(child);
+                    break;
+                }
+            }
+
+        } else if (rule.find("statement PRINTLN LPAREN expr RPAREN SEMI") != std::string::npos) {
+            // Print statement
+            std::string exprType = analyzeExpression(stmtNode->children[2]);
+            if (exprType != "int") return false; // Must print int
+
+        } else if (rule.find("statement PUTCHAR LPAREN expr RPAREN SEMI") != std::string::npos) {
+            // Putchar statement
+            std::string exprType = analyzeExpression(stmtNode->children[2]);
+            if (exprType != "int") return false; // Must print int
+
+        } else if (rule.find("statement DELETE LBRACK RBRACK expr SEMI") != std::string::npos) {
+            // Delete statement
+            std::string exprType = analyzeExpression(stmtNode->children[3]);
+            if (exprType != "int*") return false; // Must delete int*
+        }
+
+        return true;
+    }
+
+
+
+    // Function to analyze a single procedure
+    bool analyzeProcedure(TreeNode* procNode) {
+
+        // Determine current procedure name
+        if (procNode->rule.find("main INT WAIN") != std::string::npos) {
+            enterProcedure(procNode->children[1]->lexemeId);
+
+            // Extract parameters
+            // the dcls before the body's LBRACE
+            std::vector<TreeNode*> paramDcls;
+            walkPreorder(procNode, [&](TreeNode* node, TreeNode*) {
+                if (node->tokenKind == "LBRACE") return false;
+                if (node->rule.find("dcl type ID") != std::string::npos) {
+                    paramDcls.push_back(node);
+                }
+                return true;
+            });
+
+            // Add parameters to symbol table
+            for (auto dcl : paramDcls) {
+                std::string type;
+                uint32_t name = NO_SYMBOL;
+                for (auto child : dcl->children) {
+                    if (child->rule.find("type") != std::string::npos) {
+                        type = getType(child);
+                    } else if (child->tokenKind == "ID") {
+                        name = child->lexemeId;
+                    }
+                }
+                if (!declareVariable(name, type)) {
+                    return false; // Duplicate parameter
+                }
+            }
+
+            // Process local declarations
+            auto processDecl = [&](TreeNode* node, TreeNode*) -> bool {
+                if (node->rule.find("dcls dcl BECOMES") != std::string::npos) {
+                    TreeNode* dclNode = nullptr;
+
+                    for (auto child : node->children) {
+                        if (child->rule.find("dcl type ID") != std::string::npos) {
+                            dclNode = child;
+                        }
+                    }
+
+                    // Find the expression node (after BECOMES)
+                    TreeNode* exprNode = nullptr;
+                    for (size_t i = 0; i < node->children.size() - 1; i++) {
+                        if (node->children[i]->tokenKind == "BECOMES") {
+                            exprNode = node->children[i + 1];
+                            break;
+                        }
+                    }
+
+                    if (!dclNode || !exprNode) return false;
+
+                    std::string varType;
+                    uint32_t varName = NO_SYMBOL;
+                    for (auto child : dclNode->children) {
+                        if (child->rule.find("type") != std::string::npos) {
+                            varType = getType(child);
+                        } else if (child->tokenKind == "ID") {
+                            varName = child->lexemeId;
+                        }
+                    }
+
+                    // Analyze the initialization expression to get its type
+                    std::string valueType = analyzeExpression(exprNode);
+
+                    if (valueType.empty() || varType != valueType) return false;
+                    if (!declareVariable(varName, varType)) return false;
+                }
+                return true;
+            };
+
+            if (!walkPreorder(procNode, processDecl)) return false;
+
+            // Analyze statements
+            for (auto child : procNode->children) {
+                if (child->rule.find("statements") != std::string::npos) {
+                    if (!analyzeStatements(child)) return false;
+                }
+            }
+
+            // Analyze return expression
+            TreeNode* returnExpr = nullptr;
+            walkPreorder(procNode, [&](TreeNode* node, TreeNode*) {
+                // Look for the specific pattern: RETURN expr SEMI (anywhere in children)
+                for (size_t i = 0; i + 2 < node->children.size(); i++) {
+                    if (node->children[i]->tokenKind == "RETURN" &&
+                        node->children[i + 1]->rule.find("expr") != std::string::npos &&
+                        node->children[i + 2]->tokenKind == "SEMI") {
+                        returnExpr = node->children[i + 1];
+                        return false;
+                    }
+                }
+                return true;
+            });
+
+            if (!returnExpr) return false;
+
+            std::string returnType = analyzeExpression(returnExpr);
+            if (returnType != "int") return false;
+
+        } else if (procNode->rule.find("procedure INT ID") != std::string::npos) {
+            // Analyze regular procedure (similar to wain but different parameter handling)
+            std::string_view procName = procNode->children[1]->lexeme;
+            enterProcedure(procNode->children[1]->lexemeId);
+
+            // Add parameters to symbol table
+            bool paramError = false;
+            for (auto child : procNode->children) {
+                if (child->rule.find("params") != std::string::npos) {
+                    // Walk down the right-recursive paramlist
+                    TreeNode* paramsNode = child;
+                    while (paramsNode && paramsNode->tokenKind != ".EMPTY") {
+                        if (paramsNode->rule.find("params paramlist") != std::string::npos) {
+                            // Go to paramlist
+                            paramsNode = paramsNode->children[0];
+                        } else if (paramsNode->rule.find("paramlist dcl COMMA paramlist") != std::string::npos) {
+                            // First dcl
+                            auto dclNode = paramsNode->children[0];
+                            std::string type;
+                            uint32_t name = NO_SYMBOL;
+                            std::string_view nameText;
+                            for (auto dclChild : dclNode->children) {
+                                if (dclChild->rule.find("type") != std::string::npos) {
+                                    type = getType(dclChild);
+                                } else if (dclChild->tokenKind == "ID") {
+                                    name = dclChild->lexemeId;
+                                    nameText = dclChild->lexeme;
+                                }
+                            }
+                            // Check for duplicate parameter
+                            if (!declareVariable(name, type)) {
+                                std::cerr << "ERROR: In procedure [" << procName << "]: Duplicate variable name: " << nameText << std::endl;
+                                paramError = true;
+                                break;
+                            }
+                            // Then process remaining parameters
+                            paramsNode = paramsNode->children[2];
+                        } else if (paramsNode->rule.find("paramlist dcl") != std::string::npos) {
+                            // Single dcl
+                            auto dclNode = paramsNode->children[0];
+                            std::string type;
+                            uint32_t name = NO_SYMBOL;
+                            std::string_view nameText;
+                            for (auto dclChild : dclNode->children) {
+                                if (dclChild->rule.find("type") != std::string::npos) {
+                                    type = getType(dclChild);
+                                } else if (dclChild->tokenKind == "ID") {
+                                    name = dclChild->lexemeId;
+                                    nameText = dclChild->lexeme;
+                                }
+                            }
+                            // Check for duplicate parameter
+                            if (!declareVariable(name, type)) {
+                                std::cerr << "ERROR: In procedure [" << procName << "]: Duplicate variable name: " << nameText << std::endl;
+                                paramError = true;
+                            }
+                            break;
+                        } else {
+                            break;
+                        }
+                    }
+                    break;
+                }
+            }
+
+            if (paramError) {
+                return false;
+            }
+
+            // Process local declarations (similar to wain)
+            auto processDecl = [&](TreeNode* node, TreeNode*) -> bool {
+                if (node->rule.find("dcls dcl BECOMES") != std::string::npos) {
+                    TreeNode* dclNode = nullptr;
+                    TreeNode* exprNode = nullptr;
+
+                    for (auto child : node->children) {
+                        if (child->rule.find("dcl type ID") != std::string::npos) {
+                            dclNode = child;
+                        }
+                    }
+
+                    // Find the expression node (after BECOMES)
+                    for (size_t i = 0; i < node->children.size() - 1; i++) {
+                        if (node->children[i]->tokenKind == "BECOMES") {
+                            exprNode = node->children[i + 1];
+                            break;
+                        }
+                    }
+
+                    if (!dclNode || !exprNode) {
+                        return false;
+                    }
+
+                    std::string varType;
+                    uint32_t varName = NO_SYMBOL;
+                    for (auto child : dclNode->children) {
+                        if (child->rule.find("type") != std::string::npos) {
+                            varType = getType(child);
+                        } else if (child->tokenKind == "ID") {
+                            varName = child->lexemeId;
+                        }
+                    }
+
+                    // Analyze the initialization expression to get its type
+                    std::string valueType = analyzeExpression(exprNode);
+
+                    if (valueType.empty() || varType != valueType) {
+                        return false;
+                    }
+                    if (!declareVariable(varName, varType)) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+            if (!walkPreorder(procNode, processDecl)) {
+                return false;
+            }
+
+            // Analyze statements
+            for (auto child : procNode->children) {
+                if (child->rule.find("statements") != std::string::npos) {
+                    if (!analyzeStatements(child)) {
+                        return false;
+                    }
+                }
+            }
+
+            // Analyze return expression
+            TreeNode* returnExpr = nullptr;
+            walkPreorder(procNode, [&](TreeNode* node, TreeNode*) {
+                // Look for the specific pattern: RETURN expr SEMI (anywhere in children)
+                for (size_t i = 0; i + 2 < node->children.size(); i++) {
+                    if (node->children[i]->tokenKind == "RETURN" &&
+                        node->children[i + 1]->rule.find("expr") != std::string::npos &&
+                        node->children[i + 2]->tokenKind == "SEMI") {
+                        returnExpr = node->children[i + 1];
+                        return false;
+                    }
+                }
+                return true;
+            });
+
+            if (!returnExpr) {
+                return false;
+            }
+
+            std::string returnType = analyzeExpression(returnExpr);
+            if (returnType != "int") {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Main semantic analysis function
+    bool semanticAnalysis(TreeNode* root) {
+
+        // Analyze procedures in declaration order, building the procedure table as we go
+        return walkPreorder(root, [&](TreeNode* node, TreeNode*) -> bool {
+            if (node->rule.find("procedure INT ID") != std::string::npos ||
+                node->rule.find("main INT WAIN") != std::string::npos) {
+
+                // First, add this procedure's signature to the table
+                uint32_t procName;
+                std::vector<std::string> paramTypes;
+
+                if (node->rule.find("main INT WAIN") != std::string::npos) {
+                    procName = node->children[1]->lexemeId;
+
+                    // Find parameter types for wain
+                    // the dcls before the body's LBRACE
+                    walkPreorder(node, [&](TreeNode* n, TreeNode*) {
+                        if (n->tokenKind == "LBRACE") return false;
+                        if (n->rule.find("dcl type ID") != std::string::npos) {
+                            for (auto child : n->children) {
+                                if (child->rule.find("type") != std::string::npos) {
+                                    std::string paramType = getType(child);
+                                    paramTypes.push_back(paramType);
+                                    break;
+                                }
+                            }
+                        }
+                        return true;
+                    });
+
+                    if (paramTypes.size() != 2 || paramTypes[1] != "int") {
+                        return false;
+                    }
+                } else {
+                    procName = node->children[1]->lexemeId;
+
+                    // Check for duplicate declaration
+                    if (findProcedure(procName)) {
+                        return false;
+                    }
+
+                    // Extract parameter types
+                    for (auto child : node->children) {
+                        if (child->rule.find("params") != std::string::npos) {
+                            // Walk down the right-recursive paramlist
+                            TreeNode* paramsNode = child;
+                            while (paramsNode && paramsNode->tokenKind != ".EMPTY") {
+                                if (paramsNode->rule.find("params paramlist") != std::string::npos) {
+                                    // Go to paramlist
+                                    paramsNode = paramsNode->children[0];
+                                } else if (paramsNode->rule.find("paramlist dcl COMMA paramlist") != std::string::npos) {
+                                    // First dcl
+                                    auto dclNode = paramsNode->children[0];
+                                    for (auto dclChild : dclNode->children) {
+                                        if (dclChild->rule.find("type") != std::string::npos) {
+                                            std::string paramType = getType(dclChild);
+                                            paramTypes.push_back(paramType);
+                                            break;
+                                        }
+                                    }
+                                    // Then process remaining parameters
+                                    paramsNode = paramsNode->children[2];
+                                } else if (paramsNode->rule.find("paramlist dcl") != std::string::npos) {
+                                    // Single dcl
+                                    auto dclNode = paramsNode->children[0];
+                                    for (auto dclChild : dclNode->children) {
+                                        if (dclChild->rule.find("type") != std::string::npos) {
+                                            std::string paramType = getType(dclChild);
+                                            paramTypes.push_back(paramType);
+                                            break;
+                                        }
+                                    }
+                                    break;
+                                } else {
+                                    break;
+                                }
+                            }
+                            break;
+                        }
+                    }
+                }
+
+                // Add to tables (this makes it available for subsequent procedures to call)
+                if (procName >= tables.size()) return false;
+                tables[procName].declared = true;
+                tables[procName].paramTypes = paramTypes;
+
+                // Now analyze this procedure
+                if (!analyzeProcedure(node)) {
+                    return false;
+                }
+            }
+
+            return true;
+        });
+    }
+
+    // Function to annotate types in the parse tree
+    void annotateTypes(TreeNode* root) {
+        // Annotate children first
+        walkPostorder(root, [](TreeNode* node) {
+            // Annotate current node if it's an expression
+            if (isExpression(node)) {
+                if (node->tokenKind == "NUM") {
+                    node->type = "int";
+                } else if (node->tokenKind == "NULL") {
+                    node->type = "int*";
+                } else if (node->tokenKind == "ID") {
+                    // Don't overwrite types already set by setIdTypes()
+                    // and don't set default fallback types (they should be set correctly by setIdTypes)
+                } else if (!node->isTerminal()) {
+                    // For nonterminal expressions, derive type from children
+                    std::string_view lhs = node->rule.substr(0, node->rule.find(' '));
+                    if (lhs == "expr" || lhs == "term" || lhs == "factor") {
+                        // Only set type if not already set by semantic analysis
+                        if (node->type.empty()) {
+                        // Find the first child that has a type
+                        for (auto child : node->children) {
+                            if (!child->type.empty()) {
+                                node->type = child->type;
+                                break;
+                            }
+                        }
+                        // If no child has type, default to int
+                        if (node->type.empty()) {
+                            node->type = "int";
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    // Function to set ID types based on their declarations
+    void setIdTypes(TreeNode* root) {
+        if (!root) return;
+
+        // Simple approach: traverse the tree and set types, with explicit handling for procedure names
+        auto setIdType = [&](TreeNode* node, TreeNode* parent) {
+            if (node->tokenKind == "ID") {
+                uint32_t name = node->lexemeId;
+
+                // First, check if this is a procedure name declaration and explicitly set empty type
+                if (parent && !parent->isTerminal() && parent->rule.find("procedure INT ID") == 0) {
+                    if (parent->children.size() > 1 && parent->children[1] == node) {
+                        node->type = ""; // Explicitly ensure procedure names have no type
+                        return true;
+                    }
+                }
+
+                // Skip procedure calls (they shouldn't have types)
+                if (parent && !parent->isTerminal() && parent->rule.find("factor ID LPAREN") == 0) {
+                    node->type = "";
+                    return true;
+                }
+
+                // For variable declarations, set type from the declaration
+                if (parent && !parent->isTerminal() && parent->rule.find("dcl type ID") != std::string::npos) {
+                    for (auto sibling : parent->children) {
+                        if (!sibling->isTerminal() && sibling->rule.find("type") != std::string::npos) {
+                            node->type = getType(sibling);
+                            return true;
+                        }
+                    }
+                }
+
+                // For variable references, look up in current procedure's symbol table
+                if (name < variableTypes.size() && !variableTypes[name].empty()) {
+                    node->type = variableTypes[name];
+                }
+            }
+            return true;
+        };
+
+        // Traverse within each procedure context
+        walkPreorder(root, [&](TreeNode* node, TreeNode*) {
+            if (!node->isTerminal() && 
+                (node->rule.find("main INT WAIN") != std::string::npos ||
+                 node->rule.find("procedure INT ID") != std::string::npos)) {
+
+                uint32_t oldProcedure = currentProcedure;
+                if (node->children.size() > 1) enterProcedure(node->children[1]->lexemeId);
+
+                walkPreorder(node, setIdType);
+                enterProcedure(oldProcedure);
+            }
+            return true;
+        });
+    }
+
+public:
+    // Checks the tree and annotates its types; false if it does not type
+    // check. Its lexeme IDs are all below lexemeCount.
+    bool check(TreeNode* root, size_t lexemeCount) {
+        tables.assign(lexemeCount, {});
+        variableTypes.assign(lexemeCount, "");
+        currentProcedure = NO_SYMBOL;
+        if (!semanticAnalysis(root)) return false;
+        annotateTypes(root);
+        setIdTypes(root);  // Run this last to have final say on ID types
+        return true;
+    }
+};
+
+#endif